@@ -12,21 +12,23 @@ Rcpp::Rostream<false>& Rcpp::Rcerr = Rcpp::Rcpp_cerr_get();
 #endif
 
 // rcpp_alk
-Rcpp::IntegerVector rcpp_alk(const Rcpp::DataFrame gr, const bool shortest, const bool quiet);
-RcppExport SEXP _spatialcluster_rcpp_alk(SEXP grSEXP, SEXP shortestSEXP, SEXP quietSEXP) {
+Rcpp::IntegerVector rcpp_alk(const Rcpp::DataFrame gr, const bool shortest, const bool quiet, const std::string precision, const double time_budget);
+RcppExport SEXP _spatialcluster_rcpp_alk(SEXP grSEXP, SEXP shortestSEXP, SEXP quietSEXP, SEXP precisionSEXP, SEXP time_budgetSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< const Rcpp::DataFrame >::type gr(grSEXP);
     Rcpp::traits::input_parameter< const bool >::type shortest(shortestSEXP);
     Rcpp::traits::input_parameter< const bool >::type quiet(quietSEXP);
-    rcpp_result_gen = Rcpp::wrap(rcpp_alk(gr, shortest, quiet));
+    Rcpp::traits::input_parameter< const std::string >::type precision(precisionSEXP);
+    Rcpp::traits::input_parameter< const double >::type time_budget(time_budgetSEXP);
+    rcpp_result_gen = Rcpp::wrap(rcpp_alk(gr, shortest, quiet, precision, time_budget));
     return rcpp_result_gen;
 END_RCPP
 }
 // rcpp_clk
-Rcpp::IntegerVector rcpp_clk(const Rcpp::DataFrame gr_full, const Rcpp::DataFrame gr, const bool shortest, const bool quiet);
-RcppExport SEXP _spatialcluster_rcpp_clk(SEXP gr_fullSEXP, SEXP grSEXP, SEXP shortestSEXP, SEXP quietSEXP) {
+Rcpp::IntegerVector rcpp_clk(const Rcpp::DataFrame gr_full, const Rcpp::DataFrame gr, const bool shortest, const bool quiet, const std::string precision, const double time_budget);
+RcppExport SEXP _spatialcluster_rcpp_clk(SEXP gr_fullSEXP, SEXP grSEXP, SEXP shortestSEXP, SEXP quietSEXP, SEXP precisionSEXP, SEXP time_budgetSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -34,63 +36,336 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< const Rcpp::DataFrame >::type gr(grSEXP);
     Rcpp::traits::input_parameter< const bool >::type shortest(shortestSEXP);
     Rcpp::traits::input_parameter< const bool >::type quiet(quietSEXP);
-    rcpp_result_gen = Rcpp::wrap(rcpp_clk(gr_full, gr, shortest, quiet));
+    Rcpp::traits::input_parameter< const std::string >::type precision(precisionSEXP);
+    Rcpp::traits::input_parameter< const double >::type time_budget(time_budgetSEXP);
+    rcpp_result_gen = Rcpp::wrap(rcpp_clk(gr_full, gr, shortest, quiet, precision, time_budget));
+    return rcpp_result_gen;
+END_RCPP
+}
+// rcpp_clk_external
+Rcpp::IntegerVector rcpp_clk_external(const Rcpp::NumericMatrix xy, const Rcpp::DataFrame gr, const bool shortest, const bool quiet, const std::string precision, const std::string prefix, const double max_edges, const double time_budget);
+RcppExport SEXP _spatialcluster_rcpp_clk_external(SEXP xySEXP, SEXP grSEXP, SEXP shortestSEXP, SEXP quietSEXP, SEXP precisionSEXP, SEXP prefixSEXP, SEXP max_edgesSEXP, SEXP time_budgetSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const Rcpp::NumericMatrix >::type xy(xySEXP);
+    Rcpp::traits::input_parameter< const Rcpp::DataFrame >::type gr(grSEXP);
+    Rcpp::traits::input_parameter< const bool >::type shortest(shortestSEXP);
+    Rcpp::traits::input_parameter< const bool >::type quiet(quietSEXP);
+    Rcpp::traits::input_parameter< const std::string >::type precision(precisionSEXP);
+    Rcpp::traits::input_parameter< const std::string >::type prefix(prefixSEXP);
+    Rcpp::traits::input_parameter< const double >::type max_edges(max_edgesSEXP);
+    Rcpp::traits::input_parameter< const double >::type time_budget(time_budgetSEXP);
+    rcpp_result_gen = Rcpp::wrap(rcpp_clk_external(xy, gr, shortest, quiet, precision, prefix, max_edges, time_budget));
     return rcpp_result_gen;
 END_RCPP
 }
 // rcpp_cut_tree
-Rcpp::IntegerVector rcpp_cut_tree(const Rcpp::DataFrame tree, const int ncl, const bool shortest, const bool quiet);
-RcppExport SEXP _spatialcluster_rcpp_cut_tree(SEXP treeSEXP, SEXP nclSEXP, SEXP shortestSEXP, SEXP quietSEXP) {
+Rcpp::IntegerVector rcpp_cut_tree(const Rcpp::DataFrame tree, const int ncl, const bool shortest, const int min_size, const Rcpp::NumericVector weights, const double min_weight, const double time_budget, const bool quiet, const std::string precision);
+RcppExport SEXP _spatialcluster_rcpp_cut_tree(SEXP treeSEXP, SEXP nclSEXP, SEXP shortestSEXP, SEXP min_sizeSEXP, SEXP weightsSEXP, SEXP min_weightSEXP, SEXP time_budgetSEXP, SEXP quietSEXP, SEXP precisionSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< const Rcpp::DataFrame >::type tree(treeSEXP);
     Rcpp::traits::input_parameter< const int >::type ncl(nclSEXP);
     Rcpp::traits::input_parameter< const bool >::type shortest(shortestSEXP);
+    Rcpp::traits::input_parameter< const int >::type min_size(min_sizeSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::NumericVector >::type weights(weightsSEXP);
+    Rcpp::traits::input_parameter< const double >::type min_weight(min_weightSEXP);
+    Rcpp::traits::input_parameter< const double >::type time_budget(time_budgetSEXP);
     Rcpp::traits::input_parameter< const bool >::type quiet(quietSEXP);
-    rcpp_result_gen = Rcpp::wrap(rcpp_cut_tree(tree, ncl, shortest, quiet));
+    Rcpp::traits::input_parameter< const std::string >::type precision(precisionSEXP);
+    rcpp_result_gen = Rcpp::wrap(rcpp_cut_tree(tree, ncl, shortest, min_size, weights, min_weight, time_budget, quiet, precision));
+    return rcpp_result_gen;
+END_RCPP
+}
+// rcpp_cut_tree_batch
+Rcpp::IntegerMatrix rcpp_cut_tree_batch(const Rcpp::DataFrame tree, const Rcpp::NumericMatrix d, const int ncl, const bool shortest, const int min_size, const Rcpp::NumericVector weights, const double min_weight, const double time_budget, const std::string precision, const int nthreads);
+RcppExport SEXP _spatialcluster_rcpp_cut_tree_batch(SEXP treeSEXP, SEXP dSEXP, SEXP nclSEXP, SEXP shortestSEXP, SEXP min_sizeSEXP, SEXP weightsSEXP, SEXP min_weightSEXP, SEXP time_budgetSEXP, SEXP precisionSEXP, SEXP nthreadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const Rcpp::DataFrame >::type tree(treeSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::NumericMatrix >::type d(dSEXP);
+    Rcpp::traits::input_parameter< const int >::type ncl(nclSEXP);
+    Rcpp::traits::input_parameter< const bool >::type shortest(shortestSEXP);
+    Rcpp::traits::input_parameter< const int >::type min_size(min_sizeSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::NumericVector >::type weights(weightsSEXP);
+    Rcpp::traits::input_parameter< const double >::type min_weight(min_weightSEXP);
+    Rcpp::traits::input_parameter< const double >::type time_budget(time_budgetSEXP);
+    Rcpp::traits::input_parameter< const std::string >::type precision(precisionSEXP);
+    Rcpp::traits::input_parameter< const int >::type nthreads(nthreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(rcpp_cut_tree_batch(tree, d, ncl, shortest, min_size, weights, min_weight, time_budget, precision, nthreads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// rcpp_ahulls
+Rcpp::DataFrame rcpp_ahulls(const Rcpp::NumericVector x, const Rcpp::NumericVector y, const Rcpp::IntegerVector cluster, const double alpha, const int nthreads);
+RcppExport SEXP _spatialcluster_rcpp_ahulls(SEXP xSEXP, SEXP ySEXP, SEXP clusterSEXP, SEXP alphaSEXP, SEXP nthreadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const Rcpp::NumericVector >::type x(xSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::NumericVector >::type y(ySEXP);
+    Rcpp::traits::input_parameter< const Rcpp::IntegerVector >::type cluster(clusterSEXP);
+    Rcpp::traits::input_parameter< const double >::type alpha(alphaSEXP);
+    Rcpp::traits::input_parameter< const int >::type nthreads(nthreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(rcpp_ahulls(x, y, cluster, alpha, nthreads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// rcpp_dmat_file_edges
+Rcpp::NumericVector rcpp_dmat_file_edges(const std::string path, const int n, const std::string type, const bool byrow, const Rcpp::IntegerVector from, const Rcpp::IntegerVector to);
+RcppExport SEXP _spatialcluster_rcpp_dmat_file_edges(SEXP pathSEXP, SEXP nSEXP, SEXP typeSEXP, SEXP byrowSEXP, SEXP fromSEXP, SEXP toSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::string >::type path(pathSEXP);
+    Rcpp::traits::input_parameter< const int >::type n(nSEXP);
+    Rcpp::traits::input_parameter< const std::string >::type type(typeSEXP);
+    Rcpp::traits::input_parameter< const bool >::type byrow(byrowSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::IntegerVector >::type from(fromSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::IntegerVector >::type to(toSEXP);
+    rcpp_result_gen = Rcpp::wrap(rcpp_dmat_file_edges(path, n, type, byrow, from, to));
+    return rcpp_result_gen;
+END_RCPP
+}
+// rcpp_feature_edges
+Rcpp::NumericVector rcpp_feature_edges(const Rcpp::NumericMatrix x, const std::string metric, const Rcpp::IntegerVector from, const Rcpp::IntegerVector to);
+RcppExport SEXP _spatialcluster_rcpp_feature_edges(SEXP xSEXP, SEXP metricSEXP, SEXP fromSEXP, SEXP toSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const Rcpp::NumericMatrix >::type x(xSEXP);
+    Rcpp::traits::input_parameter< const std::string >::type metric(metricSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::IntegerVector >::type from(fromSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::IntegerVector >::type to(toSEXP);
+    rcpp_result_gen = Rcpp::wrap(rcpp_feature_edges(x, metric, from, to));
+    return rcpp_result_gen;
+END_RCPP
+}
+// rcpp_timeseries_edges
+Rcpp::NumericVector rcpp_timeseries_edges(const Rcpp::NumericMatrix x, const std::string method, const Rcpp::IntegerVector from, const Rcpp::IntegerVector to, const int nthreads);
+RcppExport SEXP _spatialcluster_rcpp_timeseries_edges(SEXP xSEXP, SEXP methodSEXP, SEXP fromSEXP, SEXP toSEXP, SEXP nthreadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const Rcpp::NumericMatrix >::type x(xSEXP);
+    Rcpp::traits::input_parameter< const std::string >::type method(methodSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::IntegerVector >::type from(fromSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::IntegerVector >::type to(toSEXP);
+    Rcpp::traits::input_parameter< const int >::type nthreads(nthreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(rcpp_timeseries_edges(x, method, from, to, nthreads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// rcpp_kernel_edges
+Rcpp::NumericVector rcpp_kernel_edges(SEXP kernel, const int n, const Rcpp::IntegerVector from, const Rcpp::IntegerVector to, const bool symmetric, const int nthreads);
+RcppExport SEXP _spatialcluster_rcpp_kernel_edges(SEXP kernelSEXP, SEXP nSEXP, SEXP fromSEXP, SEXP toSEXP, SEXP symmetricSEXP, SEXP nthreadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type kernel(kernelSEXP);
+    Rcpp::traits::input_parameter< const int >::type n(nSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::IntegerVector >::type from(fromSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::IntegerVector >::type to(toSEXP);
+    Rcpp::traits::input_parameter< const bool >::type symmetric(symmetricSEXP);
+    Rcpp::traits::input_parameter< const int >::type nthreads(nthreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(rcpp_kernel_edges(kernel, n, from, to, symmetric, nthreads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// rcpp_full_cut
+Rcpp::DataFrame rcpp_full_cut(const Rcpp::DataFrame edges, const Rcpp::DataFrame merges, const int ncl, const int min_size);
+RcppExport SEXP _spatialcluster_rcpp_full_cut(SEXP edgesSEXP, SEXP mergesSEXP, SEXP nclSEXP, SEXP min_sizeSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const Rcpp::DataFrame >::type edges(edgesSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::DataFrame >::type merges(mergesSEXP);
+    Rcpp::traits::input_parameter< const int >::type ncl(nclSEXP);
+    Rcpp::traits::input_parameter< const int >::type min_size(min_sizeSEXP);
+    rcpp_result_gen = Rcpp::wrap(rcpp_full_cut(edges, merges, ncl, min_size));
+    return rcpp_result_gen;
+END_RCPP
+}
+// rcpp_merges_hclust
+Rcpp::List rcpp_merges_hclust(const Rcpp::DataFrame merges);
+RcppExport SEXP _spatialcluster_rcpp_merges_hclust(SEXP mergesSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const Rcpp::DataFrame >::type merges(mergesSEXP);
+    rcpp_result_gen = Rcpp::wrap(rcpp_merges_hclust(merges));
     return rcpp_result_gen;
 END_RCPP
 }
 // rcpp_full_initial
-Rcpp::IntegerVector rcpp_full_initial(const Rcpp::DataFrame gr, bool shortest);
-RcppExport SEXP _spatialcluster_rcpp_full_initial(SEXP grSEXP, SEXP shortestSEXP) {
+Rcpp::IntegerVector rcpp_full_initial(const Rcpp::DataFrame gr, bool shortest, const std::string precision);
+RcppExport SEXP _spatialcluster_rcpp_full_initial(SEXP grSEXP, SEXP shortestSEXP, SEXP precisionSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< const Rcpp::DataFrame >::type gr(grSEXP);
     Rcpp::traits::input_parameter< bool >::type shortest(shortestSEXP);
-    rcpp_result_gen = Rcpp::wrap(rcpp_full_initial(gr, shortest));
+    Rcpp::traits::input_parameter< const std::string >::type precision(precisionSEXP);
+    rcpp_result_gen = Rcpp::wrap(rcpp_full_initial(gr, shortest, precision));
     return rcpp_result_gen;
 END_RCPP
 }
 // rcpp_full_merge
-Rcpp::NumericMatrix rcpp_full_merge(const Rcpp::DataFrame gr, const std::string linkage, const bool shortest);
-RcppExport SEXP _spatialcluster_rcpp_full_merge(SEXP grSEXP, SEXP linkageSEXP, SEXP shortestSEXP) {
+Rcpp::NumericMatrix rcpp_full_merge(const Rcpp::DataFrame gr, const std::string linkage, const bool shortest, const std::string precision, const double time_budget);
+RcppExport SEXP _spatialcluster_rcpp_full_merge(SEXP grSEXP, SEXP linkageSEXP, SEXP shortestSEXP, SEXP precisionSEXP, SEXP time_budgetSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< const Rcpp::DataFrame >::type gr(grSEXP);
     Rcpp::traits::input_parameter< const std::string >::type linkage(linkageSEXP);
     Rcpp::traits::input_parameter< const bool >::type shortest(shortestSEXP);
-    rcpp_result_gen = Rcpp::wrap(rcpp_full_merge(gr, linkage, shortest));
+    Rcpp::traits::input_parameter< const std::string >::type precision(precisionSEXP);
+    Rcpp::traits::input_parameter< const double >::type time_budget(time_budgetSEXP);
+    rcpp_result_gen = Rcpp::wrap(rcpp_full_merge(gr, linkage, shortest, precision, time_budget));
+    return rcpp_result_gen;
+END_RCPP
+}
+// rcpp_knn
+Rcpp::IntegerMatrix rcpp_knn(const Rcpp::NumericMatrix xy, const int k, const bool shortest, const int nthreads);
+RcppExport SEXP _spatialcluster_rcpp_knn(SEXP xySEXP, SEXP kSEXP, SEXP shortestSEXP, SEXP nthreadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const Rcpp::NumericMatrix >::type xy(xySEXP);
+    Rcpp::traits::input_parameter< const int >::type k(kSEXP);
+    Rcpp::traits::input_parameter< const bool >::type shortest(shortestSEXP);
+    Rcpp::traits::input_parameter< const int >::type nthreads(nthreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(rcpp_knn(xy, k, shortest, nthreads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// rcpp_emst
+Rcpp::DataFrame rcpp_emst(const Rcpp::NumericMatrix xy, const int nthreads);
+RcppExport SEXP _spatialcluster_rcpp_emst(SEXP xySEXP, SEXP nthreadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const Rcpp::NumericMatrix >::type xy(xySEXP);
+    Rcpp::traits::input_parameter< const int >::type nthreads(nthreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(rcpp_emst(xy, nthreads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// rcpp_xy_dists
+Rcpp::NumericVector rcpp_xy_dists(const Rcpp::NumericMatrix xy, const Rcpp::IntegerVector from, const Rcpp::IntegerVector to);
+RcppExport SEXP _spatialcluster_rcpp_xy_dists(SEXP xySEXP, SEXP fromSEXP, SEXP toSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const Rcpp::NumericMatrix >::type xy(xySEXP);
+    Rcpp::traits::input_parameter< const Rcpp::IntegerVector >::type from(fromSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::IntegerVector >::type to(toSEXP);
+    rcpp_result_gen = Rcpp::wrap(rcpp_xy_dists(xy, from, to));
     return rcpp_result_gen;
 END_RCPP
 }
 // rcpp_mst
-Rcpp::DataFrame rcpp_mst(Rcpp::DataFrame input);
-RcppExport SEXP _spatialcluster_rcpp_mst(SEXP inputSEXP) {
+Rcpp::DataFrame rcpp_mst(Rcpp::DataFrame input, const int nthreads);
+RcppExport SEXP _spatialcluster_rcpp_mst(SEXP inputSEXP, SEXP nthreadsSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< Rcpp::DataFrame >::type input(inputSEXP);
-    rcpp_result_gen = Rcpp::wrap(rcpp_mst(input));
+    Rcpp::traits::input_parameter< const int >::type nthreads(nthreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(rcpp_mst(input, nthreads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// rcpp_radix_order
+Rcpp::IntegerVector rcpp_radix_order(const Rcpp::NumericVector x, const bool decreasing, const int nthreads);
+RcppExport SEXP _spatialcluster_rcpp_radix_order(SEXP xSEXP, SEXP decreasingSEXP, SEXP nthreadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const Rcpp::NumericVector >::type x(xSEXP);
+    Rcpp::traits::input_parameter< const bool >::type decreasing(decreasingSEXP);
+    Rcpp::traits::input_parameter< const int >::type nthreads(nthreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(rcpp_radix_order(x, decreasing, nthreads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// rcpp_redcap_many
+Rcpp::List rcpp_redcap_many(const Rcpp::List problems, const bool full_order, const std::string linkage, const bool shortest, const int nnbs, const int min_size, const std::string precision, const double time_budget, const int nthreads);
+RcppExport SEXP _spatialcluster_rcpp_redcap_many(SEXP problemsSEXP, SEXP full_orderSEXP, SEXP linkageSEXP, SEXP shortestSEXP, SEXP nnbsSEXP, SEXP min_sizeSEXP, SEXP precisionSEXP, SEXP time_budgetSEXP, SEXP nthreadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const Rcpp::List >::type problems(problemsSEXP);
+    Rcpp::traits::input_parameter< const bool >::type full_order(full_orderSEXP);
+    Rcpp::traits::input_parameter< const std::string >::type linkage(linkageSEXP);
+    Rcpp::traits::input_parameter< const bool >::type shortest(shortestSEXP);
+    Rcpp::traits::input_parameter< const int >::type nnbs(nnbsSEXP);
+    Rcpp::traits::input_parameter< const int >::type min_size(min_sizeSEXP);
+    Rcpp::traits::input_parameter< const std::string >::type precision(precisionSEXP);
+    Rcpp::traits::input_parameter< const double >::type time_budget(time_budgetSEXP);
+    Rcpp::traits::input_parameter< const int >::type nthreads(nthreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(rcpp_redcap_many(problems, full_order, linkage, shortest, nnbs, min_size, precision, time_budget, nthreads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// rcpp_scl_write
+void rcpp_scl_write(const std::string path, const Rcpp::List sections);
+RcppExport SEXP _spatialcluster_rcpp_scl_write(SEXP pathSEXP, SEXP sectionsSEXP) {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::string >::type path(pathSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::List >::type sections(sectionsSEXP);
+    rcpp_scl_write(path, sections);
+    return R_NilValue;
+END_RCPP
+}
+// rcpp_scl_read
+Rcpp::List rcpp_scl_read(const std::string path);
+RcppExport SEXP _spatialcluster_rcpp_scl_read(SEXP pathSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::string >::type path(pathSEXP);
+    rcpp_result_gen = Rcpp::wrap(rcpp_scl_read(path));
+    return rcpp_result_gen;
+END_RCPP
+}
+// rcpp_insert_points
+Rcpp::List rcpp_insert_points(const Rcpp::NumericMatrix xy, const Rcpp::NumericMatrix xy_new, const Rcpp::NumericMatrix dmat, const Rcpp::IntegerVector cluster, const int nnbs, const bool shortest);
+RcppExport SEXP _spatialcluster_rcpp_insert_points(SEXP xySEXP, SEXP xy_newSEXP, SEXP dmatSEXP, SEXP clusterSEXP, SEXP nnbsSEXP, SEXP shortestSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const Rcpp::NumericMatrix >::type xy(xySEXP);
+    Rcpp::traits::input_parameter< const Rcpp::NumericMatrix >::type xy_new(xy_newSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::NumericMatrix >::type dmat(dmatSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::IntegerVector >::type cluster(clusterSEXP);
+    Rcpp::traits::input_parameter< const int >::type nnbs(nnbsSEXP);
+    Rcpp::traits::input_parameter< const bool >::type shortest(shortestSEXP);
+    rcpp_result_gen = Rcpp::wrap(rcpp_insert_points(xy, xy_new, dmat, cluster, nnbs, shortest));
+    return rcpp_result_gen;
+END_RCPP
+}
+// rcpp_remove_points
+Rcpp::DataFrame rcpp_remove_points(const Rcpp::DataFrame tree, const Rcpp::IntegerVector remove, const int n, const bool shortest);
+RcppExport SEXP _spatialcluster_rcpp_remove_points(SEXP treeSEXP, SEXP removeSEXP, SEXP nSEXP, SEXP shortestSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const Rcpp::DataFrame >::type tree(treeSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::IntegerVector >::type remove(removeSEXP);
+    Rcpp::traits::input_parameter< const int >::type n(nSEXP);
+    Rcpp::traits::input_parameter< const bool >::type shortest(shortestSEXP);
+    rcpp_result_gen = Rcpp::wrap(rcpp_remove_points(tree, remove, n, shortest));
     return rcpp_result_gen;
 END_RCPP
 }
 // rcpp_slk
-Rcpp::IntegerVector rcpp_slk(const Rcpp::DataFrame gr_full, const Rcpp::DataFrame gr, const bool shortest, const bool quiet);
-RcppExport SEXP _spatialcluster_rcpp_slk(SEXP gr_fullSEXP, SEXP grSEXP, SEXP shortestSEXP, SEXP quietSEXP) {
+Rcpp::IntegerVector rcpp_slk(const Rcpp::DataFrame gr_full, const Rcpp::DataFrame gr, const bool shortest, const bool quiet, const std::string precision, const double time_budget);
+RcppExport SEXP _spatialcluster_rcpp_slk(SEXP gr_fullSEXP, SEXP grSEXP, SEXP shortestSEXP, SEXP quietSEXP, SEXP precisionSEXP, SEXP time_budgetSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -98,7 +373,41 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< const Rcpp::DataFrame >::type gr(grSEXP);
     Rcpp::traits::input_parameter< const bool >::type shortest(shortestSEXP);
     Rcpp::traits::input_parameter< const bool >::type quiet(quietSEXP);
-    rcpp_result_gen = Rcpp::wrap(rcpp_slk(gr_full, gr, shortest, quiet));
+    Rcpp::traits::input_parameter< const std::string >::type precision(precisionSEXP);
+    Rcpp::traits::input_parameter< const double >::type time_budget(time_budgetSEXP);
+    rcpp_result_gen = Rcpp::wrap(rcpp_slk(gr_full, gr, shortest, quiet, precision, time_budget));
+    return rcpp_result_gen;
+END_RCPP
+}
+// rcpp_slk_external
+Rcpp::IntegerVector rcpp_slk_external(const Rcpp::NumericMatrix xy, const Rcpp::DataFrame gr, const bool shortest, const bool quiet, const std::string precision, const std::string prefix, const double max_edges, const double time_budget);
+RcppExport SEXP _spatialcluster_rcpp_slk_external(SEXP xySEXP, SEXP grSEXP, SEXP shortestSEXP, SEXP quietSEXP, SEXP precisionSEXP, SEXP prefixSEXP, SEXP max_edgesSEXP, SEXP time_budgetSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const Rcpp::NumericMatrix >::type xy(xySEXP);
+    Rcpp::traits::input_parameter< const Rcpp::DataFrame >::type gr(grSEXP);
+    Rcpp::traits::input_parameter< const bool >::type shortest(shortestSEXP);
+    Rcpp::traits::input_parameter< const bool >::type quiet(quietSEXP);
+    Rcpp::traits::input_parameter< const std::string >::type precision(precisionSEXP);
+    Rcpp::traits::input_parameter< const std::string >::type prefix(prefixSEXP);
+    Rcpp::traits::input_parameter< const double >::type max_edges(max_edgesSEXP);
+    Rcpp::traits::input_parameter< const double >::type time_budget(time_budgetSEXP);
+    rcpp_result_gen = Rcpp::wrap(rcpp_slk_external(xy, gr, shortest, quiet, precision, prefix, max_edges, time_budget));
+    return rcpp_result_gen;
+END_RCPP
+}
+// rcpp_statistics
+Rcpp::List rcpp_statistics(const Rcpp::DataFrame tree, const Rcpp::NumericVector node_cluster, const Rcpp::NumericVector x, const Rcpp::NumericVector y);
+RcppExport SEXP _spatialcluster_rcpp_statistics(SEXP treeSEXP, SEXP node_clusterSEXP, SEXP xSEXP, SEXP ySEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const Rcpp::DataFrame >::type tree(treeSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::NumericVector >::type node_cluster(node_clusterSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::NumericVector >::type x(xSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::NumericVector >::type y(ySEXP);
+    rcpp_result_gen = Rcpp::wrap(rcpp_statistics(tree, node_cluster, x, y));
     return rcpp_result_gen;
 END_RCPP
 }
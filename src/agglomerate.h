@@ -0,0 +1,165 @@
+#pragma once
+
+#include "utils.h"
+#include "policies.h"
+#include "budget.h"
+#include "radix-sort.h"
+
+// --------- SHARED AGGLOMERATION CORE ----------------
+
+/* All three redcap linkages (single, average, complete) build a spanning tree
+ * by successively merging pairs of contiguous clusters, and adding to the tree
+ * the strongest edge which connects each pair. They differ only in how the
+ * next pair of clusters to be merged is selected, and in what additional
+ * state must be updated after each merge. This core holds the state common to
+ * all linkages, and runs the merge loop, delegating the linkage-specific parts
+ * to a policy class, L, which must provide:
+ *
+ * bool next (AggDat <T> &dat, MergePair &pr);
+ *      Select the next pair of clusters to be merged, returning `false` when
+ *      no further merges are possible. Linkages which also find the edge
+ *      connecting the pair may set `pr.edge`.
+ * void update (AggDat <T> &dat, const MergePair &pr);
+ *      Update linkage-specific state after `pr.cfrom` has been merged into
+ *      `pr.cto`.
+ *
+ * The comparison policy, Cmp, is either policy::Shortest (for distances) or
+ * policy::Longest (for covariances).
+ */
+
+namespace agglomerate {
+
+template <typename T>
+struct AggDat {
+    size_t n;
+
+    // The contiguity matrix is between clusters, so is modified with every
+    // merge, while the distance matrix is between vertices, so is fixed.
+    arma::Mat <int> contig_mat;
+    arma::Mat <T> d_mat;
+
+    // Cluster memberships are dynamically updated with each merge, while
+    // vert2index and index2vert are retained at initial values which map (from,
+    // to) vectors to matrix indices.
+    utils::ClusterMembers clusters;
+    indx2int_vec_t index2vert;
+    int2indx_vec_t vert2index;
+};
+
+// A pair of clusters to be merged, with `cfrom` merged into `cto`, and the
+// index into (from, to) of the edge which connects them. The edge is found by
+// the core unless it has already been set by the linkage.
+struct MergePair {
+    int cfrom, cto;
+    size_t edge;
+};
+
+template <typename T, typename Cmp>
+void init (AggDat <T> &dat,
+        const utils::IndexView &from,
+        const utils::IndexView &to,
+        const typename policy::Input <T>::type *d) {
+    dat.n = utils::sets_init (from, to, dat.vert2index,
+            dat.index2vert, dat.clusters);
+    utils_slk::mats_init <T, Cmp> (from, to, d, dat.vert2index,
+            dat.contig_mat, dat.d_mat);
+}
+
+// Complete a tree once a time budget has expired, by joining the clusters
+// merged so far with the strongest remaining (from, to) edges between them, as
+// for Kruskal's algorithm. Linkage-specific state is not updated, so the loop
+// may not be resumed after this.
+template <typename T, typename Cmp>
+void complete (AggDat <T> &dat,
+        const utils::IndexView &from,
+        const utils::IndexView &to,
+        std::vector <index_t> &treevec) {
+    std::vector <index_t> index (static_cast <size_t> (from.size ()));
+    for (size_t i = 0; i < index.size (); i++) {
+        index [i] = i;
+    }
+    radix_sort::sort_by (index, [&] (const index_t i) {
+                const int ii = static_cast <int> (i);
+                const arma::uword u = static_cast <arma::uword> (
+                            utils::vert_index (dat.vert2index, from [ii])),
+                      v = static_cast <arma::uword> (
+                            utils::vert_index (dat.vert2index, to [ii]));
+                return static_cast <double> (dat.d_mat (u, v));
+            }, Cmp::shortest);
+
+    for (auto i: index) {
+        if (treevec.size () >= (dat.n - 1)) {
+            break;
+        }
+        const int ii = static_cast <int> (i);
+        const int cfrom = dat.clusters.cluster (
+                    utils::vert_index (dat.vert2index, from [ii])),
+                  cto = dat.clusters.cluster (
+                    utils::vert_index (dat.vert2index, to [ii]));
+        if (cfrom != cto) {
+            treevec.push_back (i);
+            dat.clusters.merge (cfrom, cto);
+        }
+    }
+}
+
+// Run the merge loop through to a full spanning tree, or until the linkage is
+// unable to find any further pairs of clusters to merge. If `budget` expires
+// first, the tree is completed with `complete`, and `budget.expired ()` is
+// `true`. If `threaded`, the loop makes no calls to the R API, and so may be
+// run from worker threads, for which `budget` must be a `threaded` copy.
+//
+// @return Indices into (from, to) of the edges of the tree.
+template <typename T, typename Cmp, typename L>
+std::vector <index_t> run (AggDat <T> &dat, L &linkage,
+        const utils::IndexView &from,
+        const utils::IndexView &to,
+        budget::Budget &budget,
+        const bool quiet,
+        const bool threaded = false) {
+    const size_t n = dat.n;
+    const bool really_quiet = threaded || !(!quiet && n > 100);
+
+    std::vector <index_t> treevec;
+    treevec.reserve (n - 1);
+    MergePair pr;
+    while (treevec.size () < (n - 1)) { // tree has n - 1 edges
+        if (budget.check ()) {
+            break;
+        }
+
+        pr.edge = INFINITE_INT;
+        if (!linkage.next (dat, pr)) {
+            break;
+        }
+        if (pr.edge == INFINITE_INT) {
+            pr.edge = utils::find_shortest_connection <T, Cmp> (
+                    from, to, dat.vert2index, dat.d_mat, dat.clusters,
+                    pr.cfrom, pr.cto);
+        }
+        treevec.push_back (pr.edge);
+        utils::merge_clusters (dat.contig_mat, dat.clusters,
+                pr.cfrom, pr.cto);
+        linkage.update (dat, pr);
+
+        if (!really_quiet && treevec.size () % 100 == 0) {
+            Rcpp::Rcout << "\rBuilding tree: " << treevec.size () << " / " <<
+                n - 1;
+            Rcpp::Rcout.flush ();
+        }
+    }
+
+    if (budget.expired ()) {
+        complete <T, Cmp> (dat, from, to, treevec);
+    }
+
+    if (!really_quiet) {
+        Rcpp::Rcout << "\rBuilding tree: " << treevec.size () << " / " <<
+            n - 1 << (budget.expired () ? " -> time budget exhausted" :
+                " -> done") << std::endl;
+    }
+
+    return treevec;
+}
+
+} // end namespace agglomerate
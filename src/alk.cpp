@@ -1,180 +1,136 @@
 #include "common.h"
-#include "utils.h"
 #include "alk.h"
 
 // --------- AVERAGE LINKAGE CLUSTER ----------------
 
-void alk::alk_init (alk::ALKDat &alk_dat,
-        BinarySearchTree &tree,
-        Rcpp::IntegerVector from,
-        Rcpp::IntegerVector to,
-        Rcpp::NumericVector d) {
+template <typename T, typename Cmp>
+void alk::alk_init (alk::ALKLinkage <T, Cmp> &alk_dat,
+        const agglomerate::AggDat <T> &dat,
+        const utils::IndexView &from,
+        const utils::IndexView &to,
+        const double *d) {
 
-    size_t n = utils::sets_init (from, to, alk_dat.vert2index_map,
-            alk_dat.index2vert_map, alk_dat.index2cl_map,
-            alk_dat.cl2index_map);
-    alk_dat.n = n;
-
-    intset_t vert_set;
+    arma::uword nu = static_cast <arma::uword> (dat.n);
+    alk_dat.num_edges = arma::ones <arma::Mat <int> > (nu, nu);
+    alk_dat.avg_dist.set_size (nu, nu);
+    alk_dat.avg_dist.fill (0.0);
 
-    // Get set of unique vertices, and store binary tree of edge distances
+    // Store binary tree of edge distances, along with idx2edgewt_map and
+    // edgewt2idx_pair_map. Ids of initial edges are their indices into (from,
+    // to), so equal distances are ordered as in the input.
     for (int i = 0; i < from.size (); i++) {
-        vert_set.emplace (from [i]);
-        vert_set.emplace (to [i]);
-        tree.insert (d [i]);
-    }
-    // Construct vert2index_map to map each unique vertex to an index
-    index_t idx = 0;
-    for (auto v: vert_set) {
-        alk_dat.vert2index_map.emplace (v, idx++);
+        index_t fi = utils::vert_index (dat.vert2index, from [i]),
+                ti = utils::vert_index (dat.vert2index, to [i]);
+        arma::uword vf = static_cast <arma::uword> (fi),
+                    vt = static_cast <arma::uword> (ti);
+        alk_dat.num_edges (vf, vt) = 1;
+        alk_dat.avg_dist (vf, vt) = static_cast <T> (d [i]);
+        alk_dat.insert_key (vf, vt, fi, ti);
     }
+}
 
-    // Construct idx2edgewt_map and edgewt2idx_pair_map
-    for (int i = 0; i < from.size (); i++) {
-        index_t fi = alk_dat.vert2index_map.at (from [i]),
-                ti = alk_dat.vert2index_map.at (to [i]);
-        alk_dat.edgewt2idx_pair_map.emplace (d [i], std::make_pair (fi, ti));
-
-        // idx2edgewt_map.second is an unordered set that needs to be expanded
-        std::unordered_set <double> wtset;
-        if (alk_dat.idx2edgewt_map.find (fi) ==
-                alk_dat.idx2edgewt_map.end ()) {
-            wtset.emplace (d [i]);
-            alk_dat.idx2edgewt_map.emplace (fi, wtset);
-        } else {
-            wtset = alk_dat.idx2edgewt_map.at (fi);
-            wtset.emplace (d [i]);
-            alk_dat.idx2edgewt_map [fi] = wtset;
-        }
-
-        // repeat same for "to" vertex
-        if (alk_dat.idx2edgewt_map.find (ti) ==
-                alk_dat.idx2edgewt_map.end ()) {
-            wtset.emplace (d [i]);
-            alk_dat.idx2edgewt_map.emplace (ti, wtset);
-        } else {
-            wtset = alk_dat.idx2edgewt_map.at (ti);
-            wtset.emplace (d [i]);
-            alk_dat.idx2edgewt_map [ti] = wtset;
-        }
-    }
+// Insert the current average distance between (i, j) into the tree, replacing
+// any previous key for that pair, and map it on to the pair of clusters.
+template <typename T, typename Cmp>
+void alk::ALKLinkage <T, Cmp>::insert_key (const arma::uword i,
+        const arma::uword j, const index_t cl_i, const index_t cl_j) {
+    remove_key (i, j);
+
+    const EdgeKey <T, Cmp> key {avg_dist (i, j), next_id++};
+    tree.insert (key);
+    edgewt2idx_pair_map.emplace (key.id, std::make_pair (cl_i, cl_j));
+    idx2edgewt_map [cl_i].emplace (key.id);
+    idx2edgewt_map [cl_j].emplace (key.id);
+    pair_keys [i + j * avg_dist.n_rows] = key;
+}
 
-    arma::uword nu = static_cast <arma::uword> (n);
-    alk_dat.contig_mat = arma::zeros <arma::Mat <int> > (nu, nu);
-    alk_dat.num_edges = arma::ones <arma::Mat <int> > (nu, nu);
-    alk_dat.avg_dist.set_size (nu, nu);
-    //alk_dat.avg_dist.fill (INFINITE_DOUBLE);
-    alk_dat.avg_dist.fill (0.0);
-    alk_dat.dmat.set_size (nu, nu);
-    if (alk_dat.shortest) {
-        alk_dat.dmat.fill (INFINITE_DOUBLE);
-    } else {
-        alk_dat.dmat.fill (-INFINITE_DOUBLE);
-    }
-    for (int i = 0; i < from.length (); i++) {
-        arma::uword vf = static_cast <arma::uword> (
-                                    alk_dat.vert2index_map.at (from [i])),
-                    vt = static_cast <arma::uword> (
-                                    alk_dat.vert2index_map.at (to [i]));
-        alk_dat.contig_mat (vf, vt) = 1;
-        alk_dat.num_edges (vf, vt) = 1;
-        //alk_dat.avg_dist (vf, vt) = 0.0;
-        alk_dat.avg_dist (vf, vt) = d [i];
-        alk_dat.dmat (vf, vt) = d [i];
+template <typename T, typename Cmp>
+void alk::ALKLinkage <T, Cmp>::remove_key (const arma::uword i,
+        const arma::uword j) {
+    auto k = pair_keys.find (i + j * avg_dist.n_rows);
+    if (k != pair_keys.end ()) {
+        tree.remove (k->second);
+        edgewt2idx_pair_map.erase (k->second.id);
+        pair_keys.erase (k);
     }
 }
 
 // update both idx2edgewt and edgewt2idx maps to reflect merging of cluster m
-// into cluster l (using Guo's original notation there). The cl2index
-// and index2cl maps are updated in `merge_clusters`
-void alk::update_edgewt_maps (alk::ALKDat &alk_dat, index_t m, index_t l) {
-    std::unordered_set <double> wtsl = alk_dat.idx2edgewt_map.at (l),
-        wtsm = alk_dat.idx2edgewt_map.at (m);
-    for (auto w: wtsm) {
-        wtsl.insert (w);
+// into cluster l (using Guo's original notation there). Ids which are no
+// longer in the tree are dropped from idx2edgewt. The cluster memberships are
+// updated in `merge_clusters`
+template <typename T, typename Cmp>
+void alk::update_edgewt_maps (alk::ALKLinkage <T, Cmp> &alk_dat,
+        index_t m, index_t l) {
+    std::unordered_set <size_t> wtsl;
+    for (index_t cl: {l, m}) {
+        auto wts = alk_dat.idx2edgewt_map.find (cl);
+        if (wts != alk_dat.idx2edgewt_map.end ()) {
+            for (auto w: wts->second) {
+                if (alk_dat.edgewt2idx_pair_map.find (w) !=
+                        alk_dat.edgewt2idx_pair_map.end ()) {
+                    wtsl.insert (w);
+                }
+            }
+            alk_dat.idx2edgewt_map.erase (wts);
+        }
     }
-    alk_dat.idx2edgewt_map.erase (m);
-    alk_dat.idx2edgewt_map.erase (l);
     alk_dat.idx2edgewt_map.emplace (l, wtsl);
 
-    for (auto w: wtsl) {
-        std::pair <index_t, index_t> pr = alk_dat.edgewt2idx_pair_map.at (w);
-        bool update = true;
-        if (pr.first == m) {
-            pr.first = l;
-        } else if (pr.second == m) {
-            pr.second = l;
-        } else {
-            update = false;
+    // Any edgewt2idx pairs with entries of m have to be re-mapped to l
+    for (auto &w: alk_dat.edgewt2idx_pair_map) {
+        if (w.second.first == m) {
+            w.second.first = l;
         }
-
-        if (update) {
-            alk_dat.edgewt2idx_pair_map [w] = pr;
+        if (w.second.second == m) {
+            w.second.second = l;
         }
     }
+}
 
-    // Any edgewt2idx pairs with entries of m also have to be re-mapped to l
-    // TODO: Is there a better way to do this?
-    std::unordered_set <double> wts;
-    for (auto w: alk_dat.edgewt2idx_pair_map) {
-        if (w.second.first == m || w.second.second == m) {
-            wts.emplace (w.first);
-        }
+//' Step through to find the strongest edge that (i) connects different
+//' clusters, (ii) represents contiguous clusters, and (iii) is no stronger than
+//' the average dist between those 2 clusters. Average distances of zero are
+//' never inserted in the tree, and mark pairs with no average.
+//' @noRd
+template <typename T, typename Cmp>
+bool alk::ALKLinkage <T, Cmp>::next (agglomerate::AggDat <T> &dat,
+        agglomerate::MergePair &pr) {
+    // node used to step through successively weaker values:
+    typename BinarySearchTree <EdgeKey <T, Cmp> >::node_t * node =
+        tree.getRoot ();
+    if (node != nullptr) {
+        node = tree.tminTree (node);
     }
-    if (wts.size () > 0) {
-        for (auto w: wts) {
-            std::pair <index_t, index_t> pr = alk_dat.edgewt2idx_pair_map.at (w);
-            if (pr.first == m) {
-                pr.first = l;
-            }
-            if (pr.second == m) {
-                pr.second = l;
-            }
-            alk_dat.edgewt2idx_pair_map [w] = pr;
+    while (node != nullptr) {
+        const EdgeKey <T, Cmp> key = node->data;
+        const std::pair <index_t, index_t> lm =
+            edgewt2idx_pair_map.at (key.id);
+        const index_t l = lm.first, m = lm.second;
+        const arma::uword lu = static_cast <arma::uword> (l),
+                          mu = static_cast <arma::uword> (m);
+        const T avg = avg_dist (lu, mu);
+        if (l != m && dat.contig_mat (lu, mu) != 0 &&
+                (avg == 0.0 || !Cmp::better (key.d, avg))) {
+            // m is merged into l
+            pr.cfrom = static_cast <int> (m);
+            pr.cto = static_cast <int> (l);
+            return true;
         }
+        node = tree.nextHi (node);
     }
+
+    throw std::runtime_error ("can not go past highest node");
 }
 
-size_t alk::alk_step (alk::ALKDat &alk_dat,
-        BinarySearchTree &tree,
-        Rcpp::IntegerVector from,
-        Rcpp::IntegerVector to,
-        Rcpp::NumericVector d) {
-    // Step through to find the minimal-distance edge that (i) connects
-    // different clusters, (ii) represents contiguous clusters, and (iii) has
-    // distance greater than the average dist between those 2 clusters.
-    // T used to step through successive min values:
-    double edge_dist = tree.treeMin();
-    tree_node * node = tree.getRoot ();
-    node = tree.getNode (node, edge_dist);
-    std::pair <index_t, index_t> pr =
-        alk_dat.edgewt2idx_pair_map.at (edge_dist);
-    index_t l = pr.first, m = pr.second;
-    arma::uword lu = static_cast <arma::uword> (l),
-                mu = static_cast <arma::uword> (m);
-    while (l == m || alk_dat.contig_mat (lu, mu) == 0 ||
-            edge_dist < alk_dat.avg_dist (lu, mu)) {
-        node = tree.nextHi (node);
-        if (node == nullptr) {
-            Rcpp::stop ("can not go past highest node");
-        }
-        edge_dist = node->data;
-        pr = alk_dat.edgewt2idx_pair_map.at (edge_dist);
-        l = pr.first;
-        m = pr.second;
-        lu = static_cast <arma::uword> (l);
-        mu = static_cast <arma::uword> (m);
-    }
-    int li = static_cast <int> (l), mi = static_cast <int> (m);
-    
-    size_t ishort = utils::find_shortest_connection (from, to,
-            alk_dat.vert2index_map, alk_dat.dmat,
-            alk_dat.cl2index_map, mi, li, alk_dat.shortest);
-    // ishort is return value; an index into (from, to)
-    utils::merge_clusters (alk_dat.contig_mat,
-            alk_dat.index2cl_map,
-            alk_dat.cl2index_map, mi, li);
-    update_edgewt_maps (alk_dat, m, l);
+template <typename T, typename Cmp>
+void alk::ALKLinkage <T, Cmp>::update (agglomerate::AggDat <T> &dat,
+        const agglomerate::MergePair &pr) {
+    const index_t l = static_cast <index_t> (pr.cto),
+                  m = static_cast <index_t> (pr.cfrom);
+    const arma::uword lu = static_cast <arma::uword> (l),
+                      mu = static_cast <arma::uword> (m);
+    update_edgewt_maps (*this, m, l);
 
     /* Cluster numbers start off here the same as vertex numbers, and so are
      * initially simple indices into the vert-by-vert matrices (contig_mat,
@@ -182,108 +138,102 @@ size_t alk::alk_step (alk::ALKDat &alk_dat,
      * pre-existing ones, so are still indexed into these same matrices which do
      * not change size. Cluster merging simply means that previous rows and
      * columns of these matrices will no longer be indexed, and all new indices
-     * are derived from constantly updated values of index2cl_map and
-     * cl2index_map.
+     * are derived from constantly updated cluster memberships.
      */
 
-    for (auto cl: alk_dat.cl2index_map) {
-        if (cl.first != static_cast <int> (l) ||
-                cl.first != static_cast <int> (m)) {
-            arma::uword clu = static_cast <arma::uword> (cl.first);
-            const double tempd_l = alk_dat.avg_dist (clu, lu),
-                         tempd_m = alk_dat.avg_dist (clu, mu);
-            const int nedges_l = alk_dat.num_edges (clu, lu),
-                      nedges_m = alk_dat.num_edges (clu, mu);
-
-            alk_dat.avg_dist (clu, lu) =
-                (tempd_l * nedges_l + tempd_m * nedges_m) /
-                static_cast <double> (nedges_l + nedges_m);
-            alk_dat.num_edges (clu, lu) = nedges_l + nedges_m;
+    for (size_t cl = 0; cl < dat.clusters.size (); cl++) {
+        if (!dat.clusters.active (static_cast <int> (cl))) {
+            continue;
+        }
+        arma::uword clu = static_cast <arma::uword> (cl);
+        const T tempd_l = avg_dist (clu, lu),
+                tempd_m = avg_dist (clu, mu);
+        const int nedges_l = num_edges (clu, lu),
+                  nedges_m = num_edges (clu, mu);
+
+        avg_dist (clu, lu) = static_cast <T> (
+            (tempd_l * nedges_l + tempd_m * nedges_m) /
+            static_cast <double> (nedges_l + nedges_m));
+        num_edges (clu, lu) = nedges_l + nedges_m;
+
+        if (dat.contig_mat (clu, lu) == 1 || dat.contig_mat (clu, mu) == 1) {
+            dat.contig_mat (clu, lu) = 1;
+            remove_key (clu, lu);
+            remove_key (clu, mu);
+
+            if (avg_dist (clu, lu) != 0.0) {
+                insert_key (clu, lu, static_cast <index_t> (cl), l);
+            }
+        } // end if C(c, l) = 1 or C(c, m) = 1 in Guo's terminology
+    } // end for over cl
+}
 
-            if (alk_dat.contig_mat (clu, lu) == 1 ||
-                    alk_dat.contig_mat (clu, mu) == 1) {
-                alk_dat.contig_mat (clu, lu) = 1;
-                if (tempd_l > 0.0) {
-                    tree.remove (tempd_l);
-                }
-                if (tempd_m > 0.0) {
-                    tree.remove (tempd_m);
-                }
-                
-                double tempd = alk_dat.avg_dist (clu, lu);
-                if (tempd > 0.0) {
-                    tree.insert (tempd);
-                    alk_dat.edgewt2idx_pair_map [tempd] =
-                        std::make_pair (cl.first, l);
+template <typename T, typename Cmp>
+std::vector <index_t> alk::alk_tree (
+        const utils::IndexView &from,
+        const utils::IndexView &to,
+        const double *d,
+        budget::Budget &budget,
+        const bool quiet,
+        const bool threaded)
+{
+    agglomerate::AggDat <T> dat;
+    agglomerate::init <T, Cmp> (dat, from, to, d);
 
-                    std::unordered_set <double> wtset;
-                    index_t cli_idx = static_cast <index_t> (cl.first);
-                    if (alk_dat.idx2edgewt_map.find (cli_idx) ==
-                            alk_dat.idx2edgewt_map.end ()) {
-                        wtset.clear ();
-                    } else {
-                        wtset = alk_dat.idx2edgewt_map.at (cli_idx);
-                    }
-                    wtset.emplace (tempd);
-                    alk_dat.idx2edgewt_map.erase (cli_idx);
-                    alk_dat.idx2edgewt_map.emplace (cli_idx, wtset);
-                }
-            } // end if C(c, l) = 1 or C(c, m) = 1 in Guo's terminology
-        } // end if cl.first != (cfrom, cto)
-    } // end for over cl
+    alk::ALKLinkage <T, Cmp> linkage;
+    alk::alk_init (linkage, dat, from, to, d);
 
-    return ishort;
+    return agglomerate::run <T, Cmp> (dat, linkage, from, to, budget, quiet,
+            threaded);
 }
 
+template std::vector <index_t> alk::alk_tree <float, policy::Shortest> (
+        const utils::IndexView &from, const utils::IndexView &to,
+        const double *d, budget::Budget &budget, const bool quiet,
+        const bool threaded);
+template std::vector <index_t> alk::alk_tree <float, policy::Longest> (
+        const utils::IndexView &from, const utils::IndexView &to,
+        const double *d, budget::Budget &budget, const bool quiet,
+        const bool threaded);
+template std::vector <index_t> alk::alk_tree <double, policy::Shortest> (
+        const utils::IndexView &from, const utils::IndexView &to,
+        const double *d, budget::Budget &budget, const bool quiet,
+        const bool threaded);
+template std::vector <index_t> alk::alk_tree <double, policy::Longest> (
+        const utils::IndexView &from, const utils::IndexView &to,
+        const double *d, budget::Budget &budget, const bool quiet,
+        const bool threaded);
 
 //' rcpp_alk
 //'
 //' Full-order average linkage cluster redcap algorithm
 //'
+//' @param time_budget Maximal time in seconds, with `Inf` for no limit
+//'
+//' @return Indices into `gr` of the edges of the tree, with a "partial"
+//' attribute as for `rcpp_slk`.
 //' @noRd
 // [[Rcpp::export]]
 Rcpp::IntegerVector rcpp_alk (
         const Rcpp::DataFrame gr,
         const bool shortest,
-        const bool quiet)
+        const bool quiet,
+        const std::string precision,
+        const double time_budget)
 {
+    budget::Budget budget (time_budget);
+
+    // Views convert R's 1-indexed vertex numbers without copying
     Rcpp::IntegerVector from_ref = gr ["from"];
     Rcpp::IntegerVector to_ref = gr ["to"];
     Rcpp::NumericVector d = gr ["d"];
-    // Rcpp classes are always passed by reference, so cloning is necessary to
-    // avoid modifying the original data.frames.
-    Rcpp::IntegerVector from = Rcpp::clone (from_ref);
-    Rcpp::IntegerVector to = Rcpp::clone (to_ref);
-    // Index vectors are 1-indexed, so
-    from = from - 1;
-    to = to - 1;
 
-    alk::ALKDat alk_dat;
-    alk_dat.shortest = shortest;
-    BinarySearchTree tree;
-    alk::alk_init (alk_dat, tree, from, to, d);
-    const size_t n = alk_dat.n;
-    const bool really_quiet = !(!quiet && n > 100);
-
-    std::unordered_set <size_t> the_tree;
-    while (the_tree.size () < (n - 1)) { // tree has n - 1 edges
-        Rcpp::checkUserInterrupt ();
-
-        size_t ishort = alk::alk_step (alk_dat, tree, from, to, d);
-        the_tree.insert (ishort);
-
-        if (!really_quiet && the_tree.size () % 100 == 0) {
-            Rcpp::Rcout << "\rBuilding tree: " << the_tree.size () << " / " <<
-                n - 1;
-            Rcpp::Rcout.flush ();
-        }
-    }
-    if (!really_quiet) {
-        Rcpp::Rcout << "\rBuilding tree: " << the_tree.size () << " / " <<
-            n - 1 << " -> done" << std::endl;
-    }
+    const utils::IndexView from (from_ref), to (to_ref);
 
-    std::vector <int> treevec (the_tree.begin (), the_tree.end ());
+    std::vector <index_t> treevec = policy::dispatch <alk::ALKTree> (
+            precision, shortest, from, to, d.begin (), budget, quiet);
 
-    return Rcpp::wrap (treevec);
+    Rcpp::IntegerVector out = Rcpp::wrap (treevec);
+    out.attr ("partial") = budget.expired ();
+    return out;
 }
@@ -2,61 +2,113 @@
 
 // --------- AVERAGE LINKAGE CLUSTER ----------------
 
+#include "agglomerate.h"
 #include "bst.h"
 
 /* The main matrices (contig, num_edges, dmat, avg_dist) are all referenced by
  * direct indices throughout, not by vertex numbers. The latter are mapped to
- * the former by vert2index_map. Note that index2vert_map is not used for this
+ * the former by vert2index. Note that index2vert is not used for this
  * routine, but exists as dummy to pass to `sets_init`
  *
- * The index2cl and cl2index then associate those indices with clusters which
+ * The cluster memberships then associate those indices with clusters which
  * are themselves also direct indices into the matrices. Cluster merging simply
  * re-directs multiple indices onto the same cluster (index) numbers.
  *
- * The binary tree only returns minimal distances which need to be associated
- * with particular pairs of clusters. This is done with the final map,
- * edgewt2idx_pair, where the pair of indices is into clusters, requiring this
- * map to be constantly updated. This updating requires in turn a reverse map,
- * idx2edgewt, so that the weight associated with any pre-merge cluster can
- * be obtained, and the edgewt2idx clusters for that weight updated.
+ * The binary tree only returns strongest distances which need to be associated
+ * with particular pairs of clusters. Distances which are equal at the chosen
+ * precision (for example, distinct double values which collide when stored as
+ * float) must nevertheless identify distinct pairs, so the tree is keyed on
+ * (distance, id) pairs, where the id is unique to each inserted distance. The
+ * final map, edgewt2idx_pair, then maps ids to pairs of indices into clusters,
+ * requiring this map to be constantly updated. This updating requires in turn
+ * a reverse map, idx2edgewt, so that the ids associated with any pre-merge
+ * cluster can be obtained, and the edgewt2idx clusters for those ids updated.
  */
 
 namespace alk {
 
-struct ALKDat {
-    bool shortest;
-    size_t n;
+// Key of the binary tree, ordered from strongest to weakest distance
+// according to the comparison policy, Cmp, and then by id for equal distances.
+template <typename T, typename Cmp>
+struct EdgeKey {
+    T d;
+    size_t id;
 
-    std::unordered_map <double,
+    bool operator< (const EdgeKey &k) const {
+        return Cmp::better (d, k.d) || (d == k.d && id < k.id);
+    }
+    bool operator> (const EdgeKey &k) const {
+        return k < *this;
+    }
+};
+
+// Linkage policy for the shared agglomeration core, templated on the distance
+// type, T, which is either float or double, and the comparison policy, Cmp.
+// The contiguity and distance matrices are held in the core,
+// agglomerate::AggDat.
+template <typename T, typename Cmp>
+struct ALKLinkage {
+    std::unordered_map <size_t,
         std::pair <index_t, index_t> > edgewt2idx_pair_map;
-    std::unordered_map <index_t, std::unordered_set <double> >
-        idx2edgewt_map; // all wts associated with that cluster
+    std::unordered_map <index_t, std::unordered_set <size_t> >
+        idx2edgewt_map; // all ids associated with that cluster
+
+    // Current key in the tree for each (cluster, cluster) pair, indexed by
+    // position in the avg_dist matrix.
+    std::unordered_map <arma::uword, EdgeKey <T, Cmp> > pair_keys;
+    size_t next_id = 0;
+
+    arma::Mat <int> num_edges;
+    arma::Mat <T> avg_dist;
 
-    arma::Mat <int> contig_mat, num_edges;
-    arma::Mat <double> dmat, avg_dist;
+    BinarySearchTree <EdgeKey <T, Cmp> > tree;
 
-    int2indxset_map_t cl2index_map;
-    indx2int_map_t index2cl_map, index2vert_map;
-    int2indx_map_t vert2index_map;
+    void insert_key (const arma::uword i, const arma::uword j,
+            const index_t cl_i, const index_t cl_j);
+    void remove_key (const arma::uword i, const arma::uword j);
+
+    bool next (agglomerate::AggDat <T> &dat, agglomerate::MergePair &pr);
+    void update (agglomerate::AggDat <T> &dat,
+            const agglomerate::MergePair &pr);
 };
 
-void alk_init (ALKDat &alk_dat,
-        BinarySearchTree &tree,
-        Rcpp::IntegerVector from,
-        Rcpp::IntegerVector to,
-        Rcpp::NumericVector d);
+template <typename T, typename Cmp>
+void alk_init (ALKLinkage <T, Cmp> &alk_dat,
+        const agglomerate::AggDat <T> &dat,
+        const utils::IndexView &from,
+        const utils::IndexView &to,
+        const double *d);
+
+template <typename T, typename Cmp>
+void update_edgewt_maps (ALKLinkage <T, Cmp> &alk_dat, index_t l, index_t m);
 
-void update_edgewt_maps (ALKDat &alk_dat, index_t l, index_t m);
+template <typename T, typename Cmp>
+std::vector <index_t> alk_tree (
+        const utils::IndexView &from,
+        const utils::IndexView &to,
+        const double *d,
+        budget::Budget &budget,
+        const bool quiet,
+        const bool threaded = false);
 
-size_t alk_step (ALKDat &alk_dat,
-        BinarySearchTree &tree,
-        Rcpp::IntegerVector from,
-        Rcpp::IntegerVector to,
-        Rcpp::NumericVector d);
+// Target for policy::dispatch
+struct ALKTree {
+    template <typename T, typename Cmp>
+    static std::vector <index_t> run (
+            const utils::IndexView &from,
+            const utils::IndexView &to,
+            const double *d,
+            budget::Budget &budget,
+            const bool quiet) {
+        return alk_tree <T, Cmp> (from, to, d, budget, quiet);
+    }
+};
 
 } // end namespace alk
 
 Rcpp::IntegerVector rcpp_alk (
         const Rcpp::DataFrame gr,
         const bool shortest,
-        const bool quiet);
+        const bool quiet,
+        const std::string precision,
+        const double time_budget);
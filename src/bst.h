@@ -3,10 +3,10 @@
 #include <iostream>
 #include <cstdlib>
 
-// Templating with recursive pointers is much harder than simply changing the
-// typedef, and makes the code much less readable
-typedef double data_type;
-
+// The tree is templated on the type of distances stored in the nodes, which
+// is either `float` or `double`. The recursive node pointers are all of the
+// one `node_t` type within the class.
+template <typename data_type>
 struct tree_node
 {
     tree_node * lo;
@@ -15,13 +15,17 @@ struct tree_node
     data_type data;
 };
 
+template <typename data_type>
 class BinarySearchTree
 {
+    public:
+        typedef tree_node <data_type> node_t;
+
     private:
-        tree_node * root;
-        data_type tmin (tree_node * node);
-        void clear_node (tree_node * node);
-        tree_node * removeNode (tree_node * node, data_type value);
+        node_t * root;
+        data_type tmin (node_t * node);
+        void clear_node (node_t * node);
+        node_t * removeNode (node_t * node, data_type value);
 
     public:
         BinarySearchTree ()
@@ -36,30 +40,32 @@ class BinarySearchTree
         void remove (data_type value);
         data_type treeMin ();
 
-        tree_node * getRoot ();
-        tree_node * getNode (tree_node * node, data_type value);
-        tree_node * treeMinTree ();
-        tree_node * tminTree (tree_node * node);
+        node_t * getRoot ();
+        node_t * getNode (node_t * node, data_type value);
+        node_t * treeMinTree ();
+        node_t * tminTree (node_t * node);
 
-        tree_node * nextHi (tree_node * node);
+        node_t * nextHi (node_t * node);
 
         void treeClear ();
 };
 
-void BinarySearchTree::insert (data_type d)
+template <typename data_type>
+void BinarySearchTree <data_type>::insert (data_type d)
 {
-    tree_node * t = new tree_node;
-    tree_node * parent;
+    node_t * t = new node_t;
+    node_t * parent;
     t->data = d;
     t->lo = nullptr;
     t->hi = nullptr;
+    t->parent = nullptr;
     parent = nullptr;
 
     if (root == nullptr)
         root = t;
     else
     {
-        tree_node * node;
+        node_t * node;
         node = root;
         while (node != nullptr)
         {
@@ -78,13 +84,16 @@ void BinarySearchTree::insert (data_type d)
     }
 }
 
-void BinarySearchTree::remove (data_type value)
+template <typename data_type>
+void BinarySearchTree <data_type>::remove (data_type value)
 {
     root = removeNode (root, value);
 }
 
 // recursive private member function:
-tree_node * BinarySearchTree::removeNode (tree_node * node, data_type value)
+template <typename data_type>
+typename BinarySearchTree <data_type>::node_t *
+BinarySearchTree <data_type>::removeNode (node_t * node, data_type value)
 {
     if (node == nullptr)
         return node;
@@ -99,20 +108,20 @@ tree_node * BinarySearchTree::removeNode (tree_node * node, data_type value)
             node = nullptr;
         }
         else if (node->lo == nullptr) { // 1 child: hi
-            tree_node * temp = node;
+            node_t * temp = node;
             node->hi->parent = node->parent;
             node = node->hi;
             delete temp;
         }
         else if (node->hi == nullptr) { // 1 childe: lo
-            tree_node * temp = node;
+            node_t * temp = node;
             node->lo->parent = node->parent;
             node = node->lo;
             delete temp;
         }
         else // 2 children
         {
-            tree_node * temp = tminTree (node->hi);
+            node_t * temp = tminTree (node->hi);
             node->data = temp->data;
             node->hi = removeNode (node->hi, temp->data);
         }
@@ -120,12 +129,14 @@ tree_node * BinarySearchTree::removeNode (tree_node * node, data_type value)
     return node; // then the root node which needs to be updated
 }
 
-data_type BinarySearchTree::treeMin ()
+template <typename data_type>
+data_type BinarySearchTree <data_type>::treeMin ()
 {
     return tmin (root);
 }
 
-data_type BinarySearchTree::tmin (tree_node * node)
+template <typename data_type>
+data_type BinarySearchTree <data_type>::tmin (node_t * node)
 {
     while (node->lo != nullptr)
         node = node->lo;
@@ -133,12 +144,16 @@ data_type BinarySearchTree::tmin (tree_node * node)
     return node->data;
 }
 
-tree_node * BinarySearchTree::treeMinTree ()
+template <typename data_type>
+typename BinarySearchTree <data_type>::node_t *
+BinarySearchTree <data_type>::treeMinTree ()
 {
     return tminTree (root);
 }
 
-tree_node * BinarySearchTree::tminTree (tree_node * node)
+template <typename data_type>
+typename BinarySearchTree <data_type>::node_t *
+BinarySearchTree <data_type>::tminTree (node_t * node)
 {
     while (node->lo != nullptr)
         node = node->lo;
@@ -146,12 +161,14 @@ tree_node * BinarySearchTree::tminTree (tree_node * node)
     return node;
 }
 
-void BinarySearchTree::treeClear ()
+template <typename data_type>
+void BinarySearchTree <data_type>::treeClear ()
 {
     clear_node (root);
 }
 
-void BinarySearchTree::clear_node (tree_node * node)
+template <typename data_type>
+void BinarySearchTree <data_type>::clear_node (node_t * node)
 {
     if (node != nullptr)
     {
@@ -161,13 +178,17 @@ void BinarySearchTree::clear_node (tree_node * node)
     }
 }
 
-tree_node * BinarySearchTree::getRoot ()
+template <typename data_type>
+typename BinarySearchTree <data_type>::node_t *
+BinarySearchTree <data_type>::getRoot ()
 {
-    tree_node * node = root;
+    node_t * node = root;
     return node;
 }
 
-tree_node * BinarySearchTree::getNode (tree_node * node, data_type value)
+template <typename data_type>
+typename BinarySearchTree <data_type>::node_t *
+BinarySearchTree <data_type>::getNode (node_t * node, data_type value)
 {
     if (node == nullptr)
     {
@@ -184,12 +205,14 @@ tree_node * BinarySearchTree::getNode (tree_node * node, data_type value)
 		return node;
 }
 
-tree_node * BinarySearchTree::nextHi (tree_node * node)
+template <typename data_type>
+typename BinarySearchTree <data_type>::node_t *
+BinarySearchTree <data_type>::nextHi (node_t * node)
 {
     if (node->hi != nullptr)
         return tminTree (node->hi);
 
-    tree_node * y = node->parent;
+    node_t * y = node->parent;
     while (y != nullptr && node == y->hi)
     {
         node = y;
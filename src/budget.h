@@ -0,0 +1,82 @@
+#pragma once
+
+#include <chrono>
+
+// --------- TIME BUDGETS AND INTERRUPTS ----------------
+
+/* Long-running loops check for user interrupts, and for the expiry of an
+ * optional time budget, through a Budget object, rather than calling
+ * Rcpp::checkUserInterrupt on every iteration. The clock is only read once
+ * every `stride` calls to `check`, and interrupts are only checked at most once
+ * every INTERRUPT_INTERVAL, so checks are cheap enough to be made on every
+ * iteration of even the fastest loops. Budgets run from the time of their
+ * construction, and are copied into worker threads with `threaded`, which
+ * retains the same deadline while disabling interrupts.
+ *
+ * Engines which can return the best result found so far, such as cuttree,
+ * stop once a budget has expired, and callers then flag their results as
+ * partial. Engines which must return complete results, such as spanning trees
+ * and hierarchies of merges, instead finish with a cheaper method, and are
+ * flagged in the same way.
+ */
+
+namespace budget {
+
+using clock = std::chrono::steady_clock;
+
+constexpr std::chrono::milliseconds INTERRUPT_INTERVAL (100);
+
+class Budget {
+    clock::time_point deadline, next_interrupt;
+    bool timed, interrupts, is_expired = false;
+    size_t stride, count = 0;
+
+public:
+    // Budget of `seconds`, with non-finite values for no time limit, and
+    // values <= 0 for a budget which expires on the first check.
+    explicit Budget (const double seconds =
+                std::numeric_limits <double>::infinity (),
+            const bool interrupts_in = true, const size_t stride_in = 1) :
+        timed (std::isfinite (seconds)), interrupts (interrupts_in),
+        stride (std::max (stride_in, static_cast <size_t> (1))) {
+
+        const clock::time_point now = clock::now ();
+        next_interrupt = now + INTERRUPT_INTERVAL;
+        if (timed) {
+            deadline = now + std::chrono::duration_cast <clock::duration> (
+                    std::chrono::duration <double> (std::max (seconds, 0.0)));
+        }
+    }
+
+    // Copy with the same deadline for use in worker threads, which must never
+    // call the R API.
+    Budget threaded () const {
+        Budget res = *this;
+        res.interrupts = false;
+        return res;
+    }
+
+    // @return `true` if the budget has expired.
+    bool check () {
+        if (is_expired) {
+            return true;
+        }
+        if (++count < stride) {
+            return false;
+        }
+        count = 0;
+        const clock::time_point now = clock::now ();
+        if (interrupts && now >= next_interrupt) {
+            Rcpp::checkUserInterrupt ();
+            next_interrupt = now + INTERRUPT_INTERVAL;
+        }
+        is_expired = timed && now >= deadline;
+        return is_expired;
+    }
+
+    bool expired () const {
+        return is_expired;
+    }
+};
+
+} // end namespace budget
@@ -1,213 +1,280 @@
 #include "common.h"
 #include "clk.h"
+#include "radix-sort.h"
+
+#include <cstdint>
+#include <unordered_map> // std::unordered_multimap
 
 // --------- COMPLETE LINKAGE CLUSTER ----------------
 
-void clk::clk_init (clk::CLKDat &clk_dat,
-        Rcpp::IntegerVector from_full,
-        Rcpp::IntegerVector to_full,
-        Rcpp::NumericVector d_full,
-        Rcpp::IntegerVector from,
-        Rcpp::IntegerVector to,
-        Rcpp::NumericVector d) {
-    size_t n = utils::sets_init (from, to, clk_dat.vert2index_map,
-            clk_dat.index2vert_map, clk_dat.index2cl_map,
-            clk_dat.cl2index_map);
-    clk_dat.n = n;
-
-    clk_dat.edges_all.clear ();
-    clk_dat.edges_all.resize (static_cast <size_t> (from_full.size ()));
-    for (int i = 0; i < from_full.size (); i++) {
-        utils::OneEdge here;
-        here.from = from_full [i];
-        here.to = to_full [i];
-        here.dist = d_full [i];
-        clk_dat.edges_all [static_cast <size_t> (i)] = here;
-    }
-    // These edges are already passed in sorted form, so no need to explicitly
-    // sort here.
+template <typename T, typename Cmp>
+void clk::clk_init (clk::CLKLinkage <T, Cmp> &clk_dat,
+        agglomerate::AggDat <T> &dat) {
+    // The full edge list is already sorted, and is read directly from
+    // clk_dat.edges_full, so need not be copied here.
+    clk_dat.edges_full.rewind ();
 
-    clk_dat.edges_nn.clear ();
-    clk_dat.edges_nn.resize (static_cast <size_t> (from.size ()));
-    for (int i = 0; i < from.size (); i++) {
-        utils::OneEdge here;
-        here.from = from [i];
-        here.to = to [i];
-        here.dist = d [i];
-        clk_dat.edges_nn [static_cast <size_t> (i)] = here;
-    }
+    arma::uword nu = static_cast <arma::uword> (dat.n);
+    clk_dat.dmat.set_size (nu, nu);
+    clk_dat.dmat.fill (Cmp::template worst <T> ());
 
-    // Get set of unique vertices, and store binary tree of edge distances
-    intset_t vert_set;
+    // Initial contiguity is directed, from each `from` to each `to` vertex,
+    // and only becomes symmetric as clusters are merged.
+    dat.contig_mat.fill (0);
+    const utils::IndexView &from = clk_dat.from, &to = clk_dat.to;
     for (int i = 0; i < from.size (); i++) {
-        vert_set.emplace (from [i]);
-        vert_set.emplace (to [i]);
-    }
-    // Construct vert2index_map to map each unique vertex to an index
-    index_t idx = 0;
-    for (auto v: vert_set) {
-        clk_dat.vert2index_map.emplace (v, idx++);
-    }
-
-    arma::uword nu = static_cast <arma::uword> (n);
-    clk_dat.contig_mat = arma::zeros <arma::Mat <int> > (nu, nu);
-    clk_dat.dmat.zeros (nu, nu);
-    for (int i = 0; i < from.length (); i++) {
         arma::uword vf = static_cast <arma::uword> (
-                                        clk_dat.vert2index_map.at (from [i])),
+                            utils::vert_index (dat.vert2index, from [i])),
                     vt = static_cast <arma::uword> (
-                                        clk_dat.vert2index_map.at (to [i]));
-        clk_dat.contig_mat (vf, vt) = 1;
-        //clk_dat.dmat (vf, vt) = d [i]; // NOPE - all dmat = 0 at start!
+                            utils::vert_index (dat.vert2index, to [i]));
+        dat.contig_mat (vf, vt) = 1;
     }
 }
 
-//' clk_step
-//'
-//' @param ei The i'th edge of the full sorted list of edge weights
+//' Step through the full edge list to find the next edge which connects two
+//' different and contiguous clusters, and then the strongest edge of (from, to)
+//' which connects them. The cluster of its first vertex, mmin, is merged into
+//' the cluster of its second, lmin.
 //' @noRd
-size_t clk::clk_step (clk::CLKDat &clk_dat, size_t i) {
-    // find shortest _all edges that connects the two clusters
-    utils::OneEdge ei = clk_dat.edges_all [i];
-    const size_t u = clk_dat.vert2index_map.at (ei.from),
-                 v = clk_dat.vert2index_map.at (ei.to);
-    const int cl_u = clk_dat.index2cl_map.at (u),
-              cl_v = clk_dat.index2cl_map.at (v);
-
-    // Find shortest edge (or longest for covariance) in MST that connects 
-    // u and v:
-    size_t mmin = INFINITE_INT, lmin = INFINITE_INT, the_edge = INFINITE_INT;
-    double dlim = INFINITE_DOUBLE;
-    if (!clk_dat.shortest) {
-        dlim = -dlim;
+template <typename T, typename Cmp>
+bool clk::CLKLinkage <T, Cmp>::next (agglomerate::AggDat <T> &dat,
+        agglomerate::MergePair &pr) {
+    edge_sort::Edge ei;
+    while (edges_full.next (ei)) {
+        arma::uword u = static_cast <arma::uword> (
+                            utils::vert_index (dat.vert2index, ei.from)),
+                    v = static_cast <arma::uword> (
+                            utils::vert_index (dat.vert2index, ei.to));
+        const int cl_u = dat.clusters.cluster (u),
+                  cl_v = dat.clusters.cluster (v);
+
+        if (cl_u != cl_v && dat.contig_mat (u, v) == 1 &&
+                Cmp::better (static_cast <T> (ei.d), dmat (u, v))) {
+            pr.edge = utils::find_shortest_connection <T, Cmp> (from, to,
+                    dat.vert2index, dat.d_mat, dat.clusters, cl_u, cl_v);
+            const int pe = static_cast <int> (pr.edge);
+            mmin = utils::vert_index (dat.vert2index, from [pe]);
+            lmin = utils::vert_index (dat.vert2index, to [pe]);
+            pr.cfrom = dat.clusters.cluster (mmin);
+            pr.cto = dat.clusters.cluster (lmin);
+            return true;
+        }
     }
+    return false;
+}
 
-    for (size_t j = 0; j < clk_dat.edges_nn.size (); j++) {
-        utils::OneEdge ej = clk_dat.edges_nn [j];
-        size_t m = clk_dat.vert2index_map.at (ej.from),
-               l = clk_dat.vert2index_map.at (ej.to);
-        if (((clk_dat.index2cl_map.at (m) == cl_u &&
-                        clk_dat.index2cl_map.at (l) == cl_v) ||
-                    (clk_dat.index2cl_map.at (m) == cl_v &&
-                     clk_dat.index2cl_map.at (l) == cl_u)) &&
-                ((clk_dat.shortest && ej.dist < dlim) ||
-                 (!clk_dat.shortest && ej.dist > dlim))) {
-            the_edge = j;
-            mmin = m;
-            lmin = l;
-            dlim = ej.dist;
+//' Update complete linkage distances after merging the cluster of vertex m into
+//' the cluster of vertex l (using Guo's original notation). Distances are
+//' indexed by the vertices of the merging edge, not by cluster numbers.
+//' @noRd
+template <typename T, typename Cmp>
+void clk::CLKLinkage <T, Cmp>::update (agglomerate::AggDat <T> &dat,
+        const agglomerate::MergePair &) {
+    const arma::uword lu = static_cast <arma::uword> (lmin),
+                      mu = static_cast <arma::uword> (mmin);
+    for (size_t cl = 0; cl < dat.clusters.size (); cl++) {
+        if (!dat.clusters.active (static_cast <int> (cl))) {
+            continue;
+        }
+        arma::uword clu = static_cast <arma::uword> (cl);
+        const T dl = dmat (clu, lu),
+              dm = dmat (clu, mu);
+        if (Cmp::better (dm, dl)) {
+            dmat (clu, lu) = dm;
+        }
+
+        if (dat.contig_mat (clu, lu) == 1 || dat.contig_mat (clu, mu) == 1) {
+            dat.contig_mat (clu, lu) = 1;
         }
     }
-    if (fabs (dlim) == INFINITE_DOUBLE) {
-        Rcpp::stop ("minimal distance not able to be found");
+}
+
+template <typename T, typename Cmp>
+std::vector <size_t> clk::clk_tree_edges (
+        edge_sort::EdgeSource &edges_full,
+        const utils::IndexView &from,
+        const utils::IndexView &to,
+        const typename policy::Input <T>::type *d,
+        budget::Budget &budget,
+        const bool quiet,
+        const bool threaded)
+{
+    agglomerate::AggDat <T> dat;
+    agglomerate::init <T, Cmp> (dat, from, to, d);
+
+    clk::CLKLinkage <T, Cmp> linkage (edges_full, from, to);
+    clk::clk_init (linkage, dat);
+
+    return agglomerate::run <T, Cmp> (dat, linkage, from, to, budget, quiet,
+            threaded);
+}
+
+template <typename T, typename Cmp>
+std::vector <size_t> clk::clk_tree (
+        const utils::IndexView &from_full,
+        const utils::IndexView &to_full,
+        const typename policy::Input <T>::type *d_full,
+        const utils::IndexView &from,
+        const utils::IndexView &to,
+        const typename policy::Input <T>::type *d,
+        budget::Budget &budget,
+        const bool quiet,
+        const bool threaded)
+{
+    edge_sort::EdgeSource edges_full (from_full, to_full, d_full);
+    return clk::clk_tree_edges <T, Cmp> (edges_full, from, to, d, budget,
+            quiet, threaded);
+}
+
+template std::vector <size_t> clk::clk_tree <float, policy::Shortest> (
+        const utils::IndexView &from_full, const utils::IndexView &to_full,
+        const double *d_full, const utils::IndexView &from,
+        const utils::IndexView &to, const double *d, budget::Budget &budget,
+        const bool quiet, const bool threaded);
+template std::vector <size_t> clk::clk_tree <float, policy::Longest> (
+        const utils::IndexView &from_full, const utils::IndexView &to_full,
+        const double *d_full, const utils::IndexView &from,
+        const utils::IndexView &to, const double *d, budget::Budget &budget,
+        const bool quiet, const bool threaded);
+template std::vector <size_t> clk::clk_tree <double, policy::Shortest> (
+        const utils::IndexView &from_full, const utils::IndexView &to_full,
+        const double *d_full, const utils::IndexView &from,
+        const utils::IndexView &to, const double *d, budget::Budget &budget,
+        const bool quiet, const bool threaded);
+template std::vector <size_t> clk::clk_tree <double, policy::Longest> (
+        const utils::IndexView &from_full, const utils::IndexView &to_full,
+        const double *d_full, const utils::IndexView &from,
+        const utils::IndexView &to, const double *d, budget::Budget &budget,
+        const bool quiet, const bool threaded);
+
+std::vector <policy::rank_t> clk::match_ranks (
+        const utils::IndexView &from_full,
+        const utils::IndexView &to_full,
+        const std::vector <policy::rank_t> &ranks_full,
+        const utils::IndexView &from,
+        const utils::IndexView &to) {
+
+    auto pair_key = [] (const int i, const int j) {
+        return (static_cast <uint64_t> (static_cast <uint32_t> (i)) << 32) |
+            static_cast <uint64_t> (static_cast <uint32_t> (j));
+    };
+    std::unordered_multimap <uint64_t, size_t> edge_index;
+    edge_index.reserve (static_cast <size_t> (from.size ()));
+    for (int i = 0; i < from.size (); i++) {
+        edge_index.emplace (pair_key (from [i], to [i]),
+                static_cast <size_t> (i));
     }
 
-    const int merge_to_id = clk_dat.index2cl_map.at (lmin);
-    utils::merge_clusters (clk_dat.contig_mat,
-            clk_dat.index2cl_map,
-            clk_dat.cl2index_map,
-            clk_dat.index2cl_map.at (mmin),
-            merge_to_id);
-
-    for (auto cl: clk_dat.cl2index_map) {
-        if (cl.first != static_cast <int> (lmin) ||
-                cl.first != static_cast <int> (mmin)) {
-            arma::uword clu = static_cast <arma::uword> (cl.first),
-                        lu = static_cast <arma::uword> (lmin),
-                        mu = static_cast <arma::uword> (mmin);
-            const double dl = clk_dat.dmat (clu, lu),
-                  dm = clk_dat.dmat (clu, mu);
-            double dtemp = dl;
-            if ((clk_dat.shortest && dm < dl) ||
-                    (!clk_dat.shortest && dm > dl)) {
-                dtemp = dm;
-            }
-            clk_dat.dmat (clu, lu) = dtemp;
-
-            if (clk_dat.contig_mat (clu, lu) == 1 ||
-                    clk_dat.contig_mat (clu, mu) == 1) {
-                clk_dat.contig_mat (clu, lu) = 1;
-            }
+    std::vector <policy::rank_t> ranks (static_cast <size_t> (from.size ()),
+            -1);
+    for (int i = 0; i < from_full.size (); i++) {
+        const auto range = edge_index.equal_range (
+                pair_key (from_full [i], to_full [i]));
+        for (auto it = range.first; it != range.second; it++) {
+            ranks [it->second] = ranks_full [static_cast <size_t> (i)];
         }
-    } // end for over cl
+    }
+    if (std::find (ranks.begin (), ranks.end (), -1) != ranks.end ()) {
+        Rcpp::stop ("Neighbour edges must all be in the full edge list");
+    }
 
-    return the_edge;
+    return ranks;
 }
 
 //' rcpp_clk
 //'
 //' Full-order complete linkage cluster redcap algorithm
 //'
+//' @param time_budget Maximal time in seconds, with `Inf` for no limit
+//'
+//' @return Indices into `gr` of the edges of the tree, with a "partial"
+//' attribute as for `rcpp_slk`.
 //' @noRd
 // [[Rcpp::export]]
 Rcpp::IntegerVector rcpp_clk (
         const Rcpp::DataFrame gr_full,
         const Rcpp::DataFrame gr,
         const bool shortest,
-        const bool quiet)
+        const bool quiet,
+        const std::string precision,
+        const double time_budget)
 {
+    budget::Budget budget (time_budget);
+
+    // Views convert R's 1-indexed vertex numbers without copying
     Rcpp::IntegerVector from_full_ref = gr_full ["from"];
     Rcpp::IntegerVector to_full_ref = gr_full ["to"];
-    Rcpp::NumericVector d_full_ref = gr_full ["d"];
+    Rcpp::NumericVector d_full = gr_full ["d"];
     Rcpp::IntegerVector from_ref = gr ["from"];
     Rcpp::IntegerVector to_ref = gr ["to"];
-    Rcpp::NumericVector d_ref = gr ["d"];
-
-    // Rcpp classes are always passed by reference, so cloning is necessary to
-    // avoid modifying the original data.frames.
-    Rcpp::IntegerVector from_full = Rcpp::clone (from_full_ref);
-    Rcpp::IntegerVector to_full = Rcpp::clone (to_full_ref);
-    Rcpp::NumericVector d_full = Rcpp::clone (d_full_ref);
-    Rcpp::IntegerVector from = Rcpp::clone (from_ref);
-    Rcpp::IntegerVector to = Rcpp::clone (to_ref);
-    Rcpp::NumericVector d = Rcpp::clone (d_ref);
-
-    // Index vectors are 1-indexed, so
-    from_full = from_full - 1;
-    to_full = to_full - 1;
-    from = from - 1;
-    to = to - 1;
-
-    clk::CLKDat clk_dat;
-    clk_dat.shortest = shortest;
-    clk::clk_init (clk_dat, from_full, to_full, d_full, from, to, d);
-    if (clk_dat.shortest) {
-        clk_dat.dmat.fill (INFINITE_DOUBLE);
-    } else {
-        clk_dat.dmat.fill (-INFINITE_DOUBLE);
+    Rcpp::NumericVector d = gr ["d"];
+
+    const utils::IndexView from_full (from_full_ref), to_full (to_full_ref),
+          from (from_ref), to (to_ref);
+
+    // Complete linkage compares distances of the full edge list with those
+    // between neighbours, so all must be ranked on the same scale.
+    std::vector <policy::rank_t> ranks_full, ranks;
+    if (precision == "rank") {
+        ranks_full = radix_sort::ranks (d_full.begin (),
+                static_cast <size_t> (d_full.size ()), shortest);
+        ranks = clk::match_ranks (from_full, to_full, ranks_full, from, to);
     }
+    const policy::Dists dists_full {d_full.begin (), ranks_full.data ()},
+          dists {d.begin (), ranks.data ()};
 
-    const size_t n = clk_dat.edges_all.size ();
-    const bool really_quiet = !(!quiet && n > (100 * 100));
+    std::vector <size_t> treevec = policy::dispatch_order <clk::CLKTree> (
+            precision, shortest, from_full, to_full, dists_full, from, to,
+            dists, budget, quiet);
 
-    std::vector <size_t> treevec;
-    for (size_t i = 0; i < n; i++) {
-        Rcpp::checkUserInterrupt ();
+    // treevec here is an index into (from, to, d) of the nearest neighbour
+    // edges
+    Rcpp::IntegerVector out = Rcpp::wrap (treevec);
+    out.attr ("partial") = budget.expired ();
+    return out;
+}
 
-        utils::OneEdge ei = clk_dat.edges_all [i];
-        arma::uword u = static_cast <arma::uword> (
-                                    clk_dat.vert2index_map.at (ei.from)),
-                    v = static_cast <arma::uword> (
-                                    clk_dat.vert2index_map.at (ei.to));
-
-        if (clk_dat.index2cl_map.at (u) != clk_dat.index2cl_map.at (v) &&
-                clk_dat.contig_mat (u, v) == 1 &&
-                ((clk_dat.shortest && ei.dist < clk_dat.dmat (u, v)) ||
-                 (!clk_dat.shortest && ei.dist > clk_dat.dmat (u, v)))) {
-            size_t the_edge = clk_step (clk_dat, i);
-            treevec.push_back (the_edge);
-        }
-        if (!really_quiet && i % 100 == 0) {
-            Rcpp::Rcout << "\rBuilding tree: " << i << " / " << n;
-            Rcpp::Rcout.flush ();
-        }
-    }
+//' rcpp_clk_external
+//'
+//' Full-order complete linkage cluster redcap algorithm, with the full edge
+//' list generated from coordinates and sorted on disk.
+//'
+//' @param xy Numeric matrix of coordinates
+//' @param prefix Path prefix for temporary files
+//' @param max_edges Maximal number of edges held in memory while sorting
+//' @param time_budget As for `rcpp_clk`, including the time taken to sort
+//' @noRd
+// [[Rcpp::export]]
+Rcpp::IntegerVector rcpp_clk_external (
+        const Rcpp::NumericMatrix xy,
+        const Rcpp::DataFrame gr,
+        const bool shortest,
+        const bool quiet,
+        const std::string precision,
+        const std::string prefix,
+        const double max_edges,
+        const double time_budget)
+{
+    budget::Budget budget (time_budget);
 
-    if (!really_quiet) {
-        Rcpp::Rcout << "\rBuilding tree: " << n << " / " << n <<
-            " -> done" << std::endl;
-    }
+    Rcpp::IntegerVector from_ref = gr ["from"];
+    Rcpp::IntegerVector to_ref = gr ["to"];
+    Rcpp::NumericVector d = gr ["d"];
+
+    const utils::IndexView from (from_ref), to (to_ref);
+
+    edge_sort::TempFiles tmp;
+    const std::string path = edge_sort::sort_edges (xy, shortest, prefix,
+            static_cast <size_t> (max_edges), tmp);
+    edge_sort::EdgeSource edges_full (path);
+
+    // Ranking distances would require ranks of the full edge list to be held in
+    // memory, so precision "rank" is stored here as double.
+    std::vector <size_t> treevec = policy::dispatch <clk::CLKTreeEdges> (
+            precision, shortest, edges_full, from, to, d.begin (), budget,
+            quiet);
 
-    // treevec here in an index into a **sorted** version of (from, to , d)
-    return Rcpp::wrap (treevec);
+    Rcpp::IntegerVector out = Rcpp::wrap (treevec);
+    out.attr ("partial") = budget.expired ();
+    return out;
 }
@@ -1,35 +1,106 @@
 #pragma once
 
-#include "utils.h"
+#include "agglomerate.h"
+#include "edge-sort.h"
 
 // --------- COMPLETE LINKAGE CLUSTER ----------------
 
 namespace clk {
 
-struct CLKDat {
-    bool shortest;
-    size_t n;
+// Linkage policy for the shared agglomeration core. The full, sorted edge list
+// is traversed once, with clusters merged whenever an edge connects two
+// contiguous clusters with a stronger distance than the current complete
+// linkage distance between them. The edge list is read sequentially, and so
+// may be held in memory, or streamed from a sorted file. As in Guo's original
+// formulation, the cluster of the first vertex of the strongest (from, to)
+// edge connecting two clusters is merged into the cluster of the second, and
+// the linkage distances are then updated for those two vertices. Templated on
+// the distance type, T, which is either float or double, and the comparison
+// policy, Cmp.
+template <typename T, typename Cmp>
+struct CLKLinkage {
+    edge_sort::EdgeSource &edges_full;
+    const utils::IndexView &from, &to;
 
-    std::vector <utils::OneEdge> edges_all, edges_nn;
+    arma::Mat <T> dmat; // complete linkage distances between clusters
+    index_t lmin = 0, mmin = 0; // vertices of the last merge
 
-    arma::Mat <int> contig_mat;
-    arma::Mat <double> dmat;
+    CLKLinkage (edge_sort::EdgeSource &edges_full_in,
+            const utils::IndexView &from_in,
+            const utils::IndexView &to_in) :
+        edges_full (edges_full_in), from (from_in), to (to_in) {}
 
-    int2indxset_map_t cl2index_map;
-
-    indx2int_map_t index2cl_map, index2vert_map;
-    int2indx_map_t vert2index_map;
+    bool next (agglomerate::AggDat <T> &dat, agglomerate::MergePair &pr);
+    void update (agglomerate::AggDat <T> &dat,
+            const agglomerate::MergePair &pr);
 };
 
-void clk_init (CLKDat &clk_dat,
-        Rcpp::IntegerVector from_full,
-        Rcpp::IntegerVector to_full,
-        Rcpp::NumericVector d_full,
-        Rcpp::IntegerVector from,
-        Rcpp::IntegerVector to,
-        Rcpp::NumericVector d);
+template <typename T, typename Cmp>
+void clk_init (CLKLinkage <T, Cmp> &clk_dat,
+        agglomerate::AggDat <T> &dat);
+
+template <typename T, typename Cmp>
+std::vector <size_t> clk_tree (
+        const utils::IndexView &from_full,
+        const utils::IndexView &to_full,
+        const typename policy::Input <T>::type *d_full,
+        const utils::IndexView &from,
+        const utils::IndexView &to,
+        const typename policy::Input <T>::type *d,
+        budget::Budget &budget,
+        const bool quiet,
+        const bool threaded = false);
+
+template <typename T, typename Cmp>
+std::vector <size_t> clk_tree_edges (
+        edge_sort::EdgeSource &edges_full,
+        const utils::IndexView &from,
+        const utils::IndexView &to,
+        const typename policy::Input <T>::type *d,
+        budget::Budget &budget,
+        const bool quiet,
+        const bool threaded = false);
+
+// Ranks of distances of the (from, to) edges, taken from the ranks of the same
+// pairs of vertices in the full edge list, so that both are on the same scale.
+std::vector <policy::rank_t> match_ranks (
+        const utils::IndexView &from_full,
+        const utils::IndexView &to_full,
+        const std::vector <policy::rank_t> &ranks_full,
+        const utils::IndexView &from,
+        const utils::IndexView &to);
+
+// Targets for policy::dispatch_order and policy::dispatch
+struct CLKTree {
+    template <typename T, typename Cmp>
+    static std::vector <size_t> run (
+            const utils::IndexView &from_full,
+            const utils::IndexView &to_full,
+            const policy::Dists &d_full,
+            const utils::IndexView &from,
+            const utils::IndexView &to,
+            const policy::Dists &d,
+            budget::Budget &budget,
+            const bool quiet) {
+        return clk_tree <T, Cmp> (from_full, to_full,
+                d_full.template get <T> (), from, to, d.template get <T> (),
+                budget, quiet);
+    }
+};
 
-size_t clk_step (CLKDat &clk_dat, size_t i);
+struct CLKTreeEdges {
+    template <typename T, typename Cmp>
+    static std::vector <size_t> run (
+            edge_sort::EdgeSource &edges_full,
+            const utils::IndexView &from,
+            const utils::IndexView &to,
+            const double *d,
+            budget::Budget &budget,
+            const bool quiet) {
+        return clk_tree_edges <T, Cmp> (edges_full, from, to, d, budget,
+                quiet);
+    }
+};
 
 } // end namespace clk
 
@@ -37,4 +108,16 @@ Rcpp::IntegerVector rcpp_clk (
         const Rcpp::DataFrame gr_full,
         const Rcpp::DataFrame gr,
         const bool shortest,
-        const bool quiet);
+        const bool quiet,
+        const std::string precision,
+        const double time_budget);
+
+Rcpp::IntegerVector rcpp_clk_external (
+        const Rcpp::NumericMatrix xy,
+        const Rcpp::DataFrame gr,
+        const bool shortest,
+        const bool quiet,
+        const std::string precision,
+        const std::string prefix,
+        const double max_edges,
+        const double time_budget);
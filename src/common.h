@@ -6,6 +6,7 @@
 #include <vector>
 #include <limits>
 #include <random>
+#include <stdexcept> // runtime_error
 #include <string> // stoi
 #include <cmath> // round
 #include <unordered_set>
@@ -17,6 +18,9 @@ constexpr float INFINITE_FLOAT =  std::numeric_limits<float>::max ();
 constexpr double INFINITE_DOUBLE =  std::numeric_limits<double>::max ();
 constexpr int INFINITE_INT =  std::numeric_limits<int>::max ();
 
+// Generic equivalent of the above, infinite_value <T>, is in policies.h
+#include "policies.h"
+
 typedef size_t index_t;
 
 typedef std::unordered_map <int, int> int2int_map_t;
@@ -28,3 +32,11 @@ typedef std::unordered_map <int, intset_t> int2intset_map_t;
 
 typedef std::unordered_set <size_t> indxset_t;
 typedef std::unordered_map <int, indxset_t> int2indxset_map_t;
+
+// Dense equivalents of the above maps, indexed directly by vertex or matrix
+// index.
+typedef std::vector <index_t> int2indx_vec_t;
+typedef std::vector <int> indx2int_vec_t;
+
+// Value of int2indx_vec_t entries for vertices absent from an edge list
+constexpr index_t NO_INDEX = std::numeric_limits <index_t>::max ();
@@ -1,25 +1,68 @@
 #include "common.h"
+#include "utils.h"
+#include "policies.h"
 #include "cuttree.h"
+#include "threads.h"
 
-void cuttree::fill_edges (cuttree::TreeDat &tree,
-        const std::vector <int> &from,
-        const std::vector <int> &to,
-        Rcpp::NumericVector &d) {
+cuttree::Limits cuttree::make_limits (const int min_size,
+        const Rcpp::NumericVector &weights, const double min_weight,
+        const utils::IndexView &from, const utils::IndexView &to) {
+
+    if (min_size < 2) {
+        Rcpp::stop ("min_size must be at least 2");
+    }
+    if (ISNAN (min_weight) || min_weight < 0.0) {
+        Rcpp::stop ("min_weight must be non-negative");
+    }
+    cuttree::Limits limits;
+    limits.min_nodes = min_size;
+    limits.min_weight = min_weight;
+    if (weights.size () == 0) {
+        return limits;
+    }
+
+    for (int i = 0; i < from.size (); i++) {
+        if (std::max (from [i], to [i]) >= weights.size ()) {
+            Rcpp::stop ("weights must have one value for each node");
+        }
+    }
+    for (auto w: weights) {
+        if (ISNAN (w)) {
+            Rcpp::stop ("weights must not contain missing values");
+        }
+    }
+    limits.weights = weights.begin ();
+
+    return limits;
+}
+
+template <typename T>
+void cuttree::fill_edges (cuttree::TreeDat <T> &tree,
+        const utils::IndexView &from,
+        const utils::IndexView &to,
+        const double *d,
+        const double *weights) {
     std::unordered_map <int, int> vert2index_map;
     intset_t vert_set;
-    for (size_t i = 0; i < from.size (); i++) {
+    for (int i = 0; i < from.size (); i++) {
         vert_set.emplace (from [i]);
         vert_set.emplace (to [i]);
     }
 
+    if (weights != nullptr) {
+        tree.weights.resize (vert_set.size ());
+    }
     int vert_num = 0;
     for (auto v: vert_set) {
+        if (weights != nullptr) {
+            tree.weights [static_cast <size_t> (vert_num)] = weights [v];
+        }
         vert2index_map.emplace (v, vert_num++);
     }
 
     for (size_t i = 0; i < tree.edges.size (); i++) {
-        cuttree::EdgeComponent this_edge;
-        this_edge.d = d [static_cast <int> (i)];
+        cuttree::EdgeComponent <T> this_edge;
+        this_edge.d = static_cast <T> (d [i]);
         this_edge.cluster_num = 0;
         this_edge.from = vert2index_map.at (from [i]);
         this_edge.to = vert2index_map.at (to [i]);
@@ -29,7 +72,9 @@ void cuttree::fill_edges (cuttree::TreeDat &tree,
 
 // Internal sum of squared deviations of specified cluster number (this is just
 // the variance without the scaling by N)
-double cuttree::calc_ss (const std::vector <cuttree::EdgeComponent> &edges,
+template <typename T>
+double cuttree::calc_ss (
+        const std::vector <cuttree::EdgeComponent <T> > &edges,
         const int cluster_num) {
     double s2 = 0.0, s = 0.0;
     double count = 0.0;
@@ -45,7 +90,9 @@ double cuttree::calc_ss (const std::vector <cuttree::EdgeComponent> &edges,
 }
 
 // Internal mean covariance of specified cluster number 
-double cuttree::calc_covsum (const std::vector <cuttree::EdgeComponent> &edges,
+template <typename T>
+double cuttree::calc_covsum (
+        const std::vector <cuttree::EdgeComponent <T> > &edges,
         const int cluster_num) {
     double s = 0.0;
     double count = 0.0;
@@ -58,7 +105,9 @@ double cuttree::calc_covsum (const std::vector <cuttree::EdgeComponent> &edges,
     return s / count;
 }
 
-size_t cuttree::cluster_size (const std::vector <cuttree::EdgeComponent> &edges,
+template <typename T>
+size_t cuttree::cluster_size (
+        const std::vector <cuttree::EdgeComponent <T> > &edges,
         const int cluster_num) {
     size_t n = 0;
     for (auto i: edges) {
@@ -70,8 +119,9 @@ size_t cuttree::cluster_size (const std::vector <cuttree::EdgeComponent> &edges,
 }
 
 // Build connected component of tree starting from first edge.
+template <typename T>
 std::unordered_set <int> cuttree::build_one_tree (
-        std::vector <cuttree::EdgeComponent> &edges) {
+        std::vector <cuttree::EdgeComponent <T> > &edges) {
     std::unordered_set <int> tree;
 
     tree.emplace (edges [0].from);
@@ -96,21 +146,21 @@ std::unordered_set <int> cuttree::build_one_tree (
     return tree;
 }
 
+template <typename T, typename Cmp>
 cuttree::TwoSS cuttree::sum_component_ss (
-        const std::vector <cuttree::EdgeComponent> &edges,
-        const std::unordered_set <int> &tree_edges,
-        const bool shortest) {
+        const std::vector <cuttree::EdgeComponent <T> > &edges,
+        const std::unordered_set <int> &tree_edges) {
     double sa = 0.0, sa2 = 0.0, sb = 0.0, sb2 = 0.0, na = 0.0, nb = 0.0;
     for (auto e: edges) {
         if (tree_edges.find (e.from) != tree_edges.end ()) {
             sa += e.d;
-            if (shortest) {
+            if (Cmp::shortest) {
                 sa2 += e.d * e.d;
             }
             na += 1.0;
         } else {
             sb += e.d;
-            if (shortest) {
+            if (Cmp::shortest) {
                 sb2 += e.d * e.d;
             }
             nb += 1.0;
@@ -119,7 +169,7 @@ cuttree::TwoSS cuttree::sum_component_ss (
 
     cuttree::TwoSS res;
     // res.ss1 = (sa2 - sa * sa / na) / (na - 1.0); // variance
-    if (shortest) {
+    if (Cmp::shortest) {
         res.ss1 = (sa2 - sa * sa / na);
         res.ss2 = (sb2 - sb * sb / nb);
     } else { // covariances are mean values, *NOT* sums like SS values
@@ -132,15 +182,19 @@ cuttree::TwoSS cuttree::sum_component_ss (
 }
 
 // Find the component split of edges in cluster_num which yields the lowest sum
-// of internal variance.
+// of internal variance, among all splits which satisfy `limits`. Clusters are
+// trees, so removing one of `n` edges leaves two components with a total of
+// `n + 1` nodes. Splits which are not possible have `ss_diff` of
+// -INFINITE_DOUBLE.
+template <typename T, typename Cmp>
 cuttree::BestCut cuttree::find_min_cut (
-        const TreeDat &tree,
+        const TreeDat <T> &tree,
         const int cluster_num,
-        const bool shortest) {
+        const cuttree::Limits &limits) {
     size_t n = cuttree::cluster_size (tree.edges, cluster_num);
 
     // fill component vector
-    std::vector <cuttree::EdgeComponent> cluster_edges (n);
+    std::vector <cuttree::EdgeComponent <T> > cluster_edges (n);
     size_t pos = 0;
     for (auto e: tree.edges) {
         if (e.cluster_num == cluster_num) {
@@ -148,15 +202,37 @@ cuttree::BestCut cuttree::find_min_cut (
         }
     }
 
-    std::vector <cuttree::EdgeComponent> edges_copy;
+    std::vector <cuttree::EdgeComponent <T> > edges_copy;
 
     // Remove each edge in turn
     cuttree::BestCut the_cut;
     the_cut.pos = the_cut.n1 = the_cut.n2 = INFINITE_INT;
     the_cut.ss1 = the_cut.ss2 = INFINITE_DOUBLE;
-    the_cut.ss_diff = 0.0; // default, coz search is over max ss_diff
+    // default, coz search is over max ss_diff
+    the_cut.ss_diff = -INFINITE_DOUBLE;
     double ssmin = INFINITE_DOUBLE;
 
+    const size_t min_nodes = static_cast <size_t> (limits.min_nodes);
+    if (n + 1 < 2 * min_nodes) {
+        return the_cut;
+    }
+
+    const bool weighted = !tree.weights.empty ();
+    double wtot = 0.0;
+    if (weighted) {
+        std::unordered_set <int> cluster_nodes;
+        for (auto e: cluster_edges) {
+            cluster_nodes.emplace (e.from);
+            cluster_nodes.emplace (e.to);
+        }
+        for (auto v: cluster_nodes) {
+            wtot += tree.weights [static_cast <size_t> (v)];
+        }
+        if (wtot < 2.0 * limits.min_weight) {
+            return the_cut;
+        }
+    }
+
     // TODO: Rewrite this to just erase and re-insert a single edge each time
     for (int i = 0; i < static_cast <int> (n); i++) {
         edges_copy.resize (0);
@@ -166,32 +242,38 @@ cuttree::BestCut cuttree::find_min_cut (
                 edges_copy.begin ());
         edges_copy.erase (edges_copy.begin () + i);
 
-        if (edges_copy.size () < cuttree::MIN_CLUSTER_SIZE) {
-            break;
+        std::unordered_set <int> tree_edges = cuttree::build_one_tree (edges_copy);
+
+        // only include groups which satisfy the limits on both sides
+        const size_t n1 = tree_edges.size (), n2 = n + 1 - n1;
+        if (n1 < min_nodes || n2 < min_nodes) {
+            continue;
+        }
+        if (weighted) {
+            double w1 = 0.0;
+            for (auto v: tree_edges) {
+                w1 += tree.weights [static_cast <size_t> (v)];
+            }
+            if (w1 < limits.min_weight || wtot - w1 < limits.min_weight) {
+                continue;
+            }
         }
 
-        std::unordered_set <int> tree_edges = cuttree::build_one_tree (edges_copy);
+        cuttree::TwoSS ss;
+        ss = cuttree::sum_component_ss <T, Cmp> (edges_copy, tree_edges);
 
-        // only include groups with >= MIN_CLUSTER_SIZE members
-        if (tree_edges.size () >= cuttree::MIN_CLUSTER_SIZE &&
-                tree_edges.size () < (edges_copy.size () -
-                                cuttree::MIN_CLUSTER_SIZE - 1)) {
-            cuttree::TwoSS ss;
-            ss = cuttree::sum_component_ss (edges_copy, tree_edges, shortest);
-
-            if ((ss.ss1 + ss.ss2) < ssmin) { // applies to both distances & cov
-                ssmin = ss.ss1 + ss.ss2;
-                the_cut.pos = i;
-                the_cut.ss1 = ss.ss1;
-                the_cut.ss2 = ss.ss2;
-
-                the_cut.n1 = ss.n1;
-                the_cut.n2 = ss.n2;
-
-                the_cut.nodes.clear ();
-                for (auto te: tree_edges) {
-                    the_cut.nodes.emplace (te);
-                }
+        if ((ss.ss1 + ss.ss2) < ssmin) { // applies to both distances & cov
+            ssmin = ss.ss1 + ss.ss2;
+            the_cut.pos = i;
+            the_cut.ss1 = ss.ss1;
+            the_cut.ss2 = ss.ss2;
+
+            the_cut.n1 = ss.n1;
+            the_cut.n2 = ss.n2;
+
+            the_cut.nodes.clear ();
+            for (auto te: tree_edges) {
+                the_cut.nodes.emplace (te);
             }
         }
     }
@@ -204,30 +286,17 @@ cuttree::BestCut cuttree::find_min_cut (
     return the_cut;
 }
 
-//' rcpp_cut_tree
-//'
-//' Cut tree into specified number of clusters by minimising internal cluster
-//' variance.
-//'
-//' @param tree tree to be processed
-//'
-//' @return Vector of cluster IDs for each tree edge
-//' @noRd
-// [[Rcpp::export]]
-Rcpp::IntegerVector rcpp_cut_tree (const Rcpp::DataFrame tree, const int ncl,
-        const bool shortest, const bool quiet) {
-    Rcpp::IntegerVector from_in = tree ["from"];
-    Rcpp::IntegerVector to_in = tree ["to"];
-    Rcpp::NumericVector dref = tree ["d"];
-
-    std::vector <int> from = Rcpp::as <std::vector <int> > (from_in);
-    std::vector <int> to = Rcpp::as <std::vector <int> > (to_in);
-
-    cuttree::TreeDat tree_dat;
-    tree_dat.edges.resize (static_cast <size_t> (dref.size ()));
-    cuttree::fill_edges (tree_dat, from, to, dref);
-
-    cuttree::BestCut the_cut = cuttree::find_min_cut (tree_dat, 0, shortest);
+template <typename T, typename Cmp>
+std::vector <int> cuttree::cut_tree (const utils::IndexView &from,
+        const utils::IndexView &to, const double *d,
+        const int ncl, const cuttree::Limits &limits, budget::Budget &budget,
+        const bool quiet, const bool threaded) {
+    cuttree::TreeDat <T> tree_dat;
+    tree_dat.edges.resize (static_cast <size_t> (from.size ()));
+    cuttree::fill_edges (tree_dat, from, to, d, limits.weights);
+
+    cuttree::BestCut the_cut =
+        cuttree::find_min_cut <T, Cmp> (tree_dat, 0, limits);
     std::vector <double> ss_diff, ss1, ss2;
     ss_diff.push_back (the_cut.ss_diff); // ss0 - ss1 - ss2
     ss1.push_back (the_cut.ss1);
@@ -236,13 +305,15 @@ Rcpp::IntegerVector rcpp_cut_tree (const Rcpp::DataFrame tree, const int ncl,
     std::unordered_map <size_t, int> cluster_map;
     cluster_map.emplace (0, 0);
 
-    const bool really_quiet = !(!quiet && from_in.size () > 100);
+    const bool really_quiet = threaded || !(!quiet && from.size () > 100);
 
     int num_clusters = 1;
     // This loop fills the three vectors (ss_diff, ss1, ss2), as well as the
     // cluster_map.
     while (num_clusters < ncl) {
-        Rcpp::checkUserInterrupt ();
+        if (num_clusters > 1 && budget.check ()) {
+            break;
+        }
         if (!really_quiet) {
             Rcpp::Rcout << "\rNumber of clusters: " << num_clusters << " / " << ncl;
             Rcpp::Rcout.flush ();
@@ -251,18 +322,19 @@ Rcpp::IntegerVector rcpp_cut_tree (const Rcpp::DataFrame tree, const int ncl,
         auto mp = std::max_element (ss_diff.begin (), ss_diff.end ());
         long int maxi_int = std::distance (ss_diff.begin (), mp);
         size_t maxi = static_cast <size_t> (maxi_int);
-        if (cluster_map.find (maxi) == cluster_map.end ()) {
-            Rcpp::Rcout << "ss_diff has no max element in cluster_map" <<
-                std::endl;
+        const auto cl = cluster_map.find (maxi);
+        if (cl == cluster_map.end ()) {
+            throw std::runtime_error (
+                    "ss_diff has no max element in cluster_map");
         }
-        int clnum = cluster_map.at (maxi);
+        const int clnum = cl->second;
         // maxi is index of cluster to be split
 
-        if (ss_diff [maxi] == 0.0) { // no further cuts possible
+        if (ss_diff [maxi] == -INFINITE_DOUBLE) { // no further cuts possible
             break;
         }
         
-        the_cut = cuttree::find_min_cut (tree_dat, clnum, shortest);
+        the_cut = cuttree::find_min_cut <T, Cmp> (tree_dat, clnum, limits);
         // Break old clnum into 2:
         int count = 0;
         for (auto &e: tree_dat.edges) {
@@ -276,13 +348,14 @@ Rcpp::IntegerVector rcpp_cut_tree (const Rcpp::DataFrame tree, const int ncl,
             }
         }
         // find new best cut of now reduced cluster
-        the_cut = cuttree::find_min_cut (tree_dat, clnum, shortest);
+        the_cut = cuttree::find_min_cut <T, Cmp> (tree_dat, clnum, limits);
 
         ss_diff [maxi] = the_cut.ss_diff;
         ss1 [maxi] = the_cut.ss1;
         ss2 [maxi] = the_cut.ss2;
         // and also of new cluster
-        the_cut = cuttree::find_min_cut (tree_dat, num_clusters, shortest);
+        the_cut = cuttree::find_min_cut <T, Cmp> (tree_dat, num_clusters,
+                limits);
 
         ss_diff.push_back (the_cut.ss_diff);
         ss1.push_back (the_cut.ss1);
@@ -294,16 +367,154 @@ Rcpp::IntegerVector rcpp_cut_tree (const Rcpp::DataFrame tree, const int ncl,
     }
 
     if (!really_quiet) {
-        Rcpp::Rcout << " -> done" << std::endl;
+        Rcpp::Rcout << (budget.expired () ? " -> time budget exhausted" :
+                " -> done") << std::endl;
     }
 
-    Rcpp::IntegerVector res (tree_dat.edges.size ());
-    for (int i = 0; i < static_cast <int> (tree_dat.edges.size ()); i++) {
-        if (tree_dat.edges [static_cast <size_t> (i)].cluster_num == INFINITE_INT) {
+    std::vector <int> res (tree_dat.edges.size ());
+    for (size_t i = 0; i < tree_dat.edges.size (); i++) {
+        if (tree_dat.edges [i].cluster_num == INFINITE_INT) {
             res [i] = NA_INTEGER;
         } else {
-            res [i] = tree_dat.edges [static_cast <size_t> (i)].cluster_num;
+            res [i] = tree_dat.edges [i].cluster_num;
         }
     }
     return res;
 }
+
+template std::vector <int> cuttree::cut_tree <float, policy::Shortest> (
+        const utils::IndexView &from, const utils::IndexView &to,
+        const double *d, const int ncl, const cuttree::Limits &limits,
+        budget::Budget &budget, const bool quiet, const bool threaded);
+template std::vector <int> cuttree::cut_tree <float, policy::Longest> (
+        const utils::IndexView &from, const utils::IndexView &to,
+        const double *d, const int ncl, const cuttree::Limits &limits,
+        budget::Budget &budget, const bool quiet, const bool threaded);
+template std::vector <int> cuttree::cut_tree <double, policy::Shortest> (
+        const utils::IndexView &from, const utils::IndexView &to,
+        const double *d, const int ncl, const cuttree::Limits &limits,
+        budget::Budget &budget, const bool quiet, const bool threaded);
+template std::vector <int> cuttree::cut_tree <double, policy::Longest> (
+        const utils::IndexView &from, const utils::IndexView &to,
+        const double *d, const int ncl, const cuttree::Limits &limits,
+        budget::Budget &budget, const bool quiet, const bool threaded);
+
+template <typename T, typename Cmp>
+std::vector <int> cuttree::CutTreeBatch::run (const utils::IndexView &from,
+        const utils::IndexView &to, const double *d,
+        const size_t nlayers, const int ncl, const cuttree::Limits &limits,
+        const budget::Budget &budget, std::vector <int> &partial,
+        const int nthreads) {
+    const size_t nedges = static_cast <size_t> (from.size ());
+    std::vector <int> res (nedges * nlayers);
+    threads::Errors errors (nlayers);
+    partial.assign (nlayers, 0);
+
+    threads::parallel_for (nlayers, nthreads,
+            [&] (const size_t begin, const size_t end) {
+                for (size_t k = begin; k < end; k++) {
+                    errors.run (k, [&] () {
+                        budget::Budget layer_budget = budget.threaded ();
+                        const std::vector <int> cl =
+                            cuttree::cut_tree <T, Cmp> (from, to,
+                                    d + k * nedges, ncl, limits,
+                                    layer_budget, true, true);
+                        partial [k] = layer_budget.expired () ? 1 : 0;
+                        std::copy (cl.begin (), cl.end (),
+                                res.begin () + static_cast <long> (k * nedges));
+                    });
+                }
+            });
+
+    errors.stop ("Unable to cut tree for dissimilarity matrix ");
+
+    return res;
+}
+
+//' rcpp_cut_tree
+//'
+//' Cut tree into specified number of clusters by minimising internal cluster
+//' variance.
+//'
+//' @param tree tree to be processed
+//' @param min_size Minimal number of nodes in each cluster
+//' @param weights Optional weights of each node, or an empty vector
+//' @param min_weight Minimal sum of `weights` of the nodes in each cluster
+//' @param time_budget Maximal time in seconds, with `Inf` for no limit
+//'
+//' @return Vector of cluster IDs for each tree edge, with a "partial"
+//' attribute which is `TRUE` if the time budget expired before `ncl` clusters
+//' were found.
+//' @noRd
+// [[Rcpp::export]]
+Rcpp::IntegerVector rcpp_cut_tree (const Rcpp::DataFrame tree, const int ncl,
+        const bool shortest, const int min_size,
+        const Rcpp::NumericVector weights, const double min_weight,
+        const double time_budget, const bool quiet,
+        const std::string precision) {
+    Rcpp::IntegerVector from_in = tree ["from"];
+    Rcpp::IntegerVector to_in = tree ["to"];
+    Rcpp::NumericVector dref = tree ["d"];
+
+    // Vertex numbers are re-indexed in fill_edges, so the views are used here
+    // only to avoid copying the columns.
+    const utils::IndexView from (from_in), to (to_in);
+    const cuttree::Limits limits = cuttree::make_limits (min_size, weights,
+            min_weight, from, to);
+
+    budget::Budget budget (time_budget);
+
+    std::vector <int> res = policy::dispatch <cuttree::CutTree> (precision,
+            shortest, from, to, dref.begin (), ncl, limits, budget, quiet);
+
+    Rcpp::IntegerVector out = Rcpp::wrap (res);
+    out.attr ("partial") = budget.expired ();
+    return out;
+}
+
+//' rcpp_cut_tree_batch
+//'
+//' Cut one tree into specified numbers of clusters for each of several sets of
+//' edge distances, optionally in parallel.
+//'
+//' @param tree tree to be processed, with columns of "from" and "to" only
+//' @param d Matrix of distances, with one row for each tree edge, and one
+//' column for each set of distances
+//' @param min_size, weights, min_weight, time_budget As for `rcpp_cut_tree`,
+//' with all columns sharing the one time budget
+//' @param nthreads Number of threads, with values <= 0 using all available
+//'
+//' @return Matrix of cluster IDs for each tree edge, with one column for each
+//' column of `d`, and a "partial" attribute flagging columns which were not
+//' fully cut within the time budget.
+//' @noRd
+// [[Rcpp::export]]
+Rcpp::IntegerMatrix rcpp_cut_tree_batch (const Rcpp::DataFrame tree,
+        const Rcpp::NumericMatrix d, const int ncl, const bool shortest,
+        const int min_size, const Rcpp::NumericVector weights,
+        const double min_weight, const double time_budget,
+        const std::string precision, const int nthreads) {
+    Rcpp::IntegerVector from_in = tree ["from"];
+    Rcpp::IntegerVector to_in = tree ["to"];
+    if (d.nrow () != from_in.size ()) {
+        Rcpp::stop ("d must have one row for each tree edge");
+    }
+
+    const utils::IndexView from (from_in), to (to_in);
+    const size_t nlayers = static_cast <size_t> (d.ncol ());
+    const cuttree::Limits limits = cuttree::make_limits (min_size, weights,
+            min_weight, from, to);
+
+    const budget::Budget budget (time_budget);
+    std::vector <int> partial;
+
+    std::vector <int> res = policy::dispatch <cuttree::CutTreeBatch> (
+            precision, shortest, from, to, d.begin (), nlayers, ncl,
+            limits, budget, partial, nthreads);
+
+    Rcpp::IntegerMatrix out (d.nrow (), d.ncol ());
+    std::copy (res.begin (), res.end (), out.begin ());
+    Rcpp::LogicalVector partial_out (partial.begin (), partial.end ());
+    out.attr ("partial") = partial_out;
+    return out;
+}
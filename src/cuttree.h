@@ -2,18 +2,40 @@
 
 #include <unordered_map>
 
+#include "budget.h"
+
 namespace cuttree {
 
-// clusters are of edges, so size = 2 => 3 nodes
-constexpr int MIN_CLUSTER_SIZE = 2;
+// Minimal sizes of clusters, which are honoured by every cut, so that no
+// cluster is ever split into parts smaller than these. Sizes are numbers of
+// nodes, and optionally also sums of per-node `weights`, indexed by 0-based
+// vertex number, with `nullptr` for no weights.
+struct Limits {
+    int min_nodes = 3;
+    const double *weights = nullptr;
+    double min_weight = 0.0;
+};
 
+// Edge distances are stored as T, which is either float or double, while all
+// sums of squares are accumulated in double precision.
+template <typename T>
 struct EdgeComponent {
-    double d;
+    T d;
     int from, to, cluster_num;
 };
 
+// Validate the limits passed from R, which also requires weights for all
+// vertices of the tree.
+Limits make_limits (const int min_size, const Rcpp::NumericVector &weights,
+        const double min_weight, const utils::IndexView &from,
+        const utils::IndexView &to);
+
+// Weights are indexed by the internal vertex numbers of `edges`, and are empty
+// where no weights are given.
+template <typename T>
 struct TreeDat {
-    std::vector <EdgeComponent> edges;
+    std::vector <EdgeComponent <T> > edges;
+    std::vector <double> weights;
 };
 
 struct BestCut {
@@ -27,24 +49,83 @@ struct TwoSS { // 2 sums-of-squares values
     int n1, n2; // sizes of clusters
 };
 
-void fill_edges (TreeDat &tree,
-        const std::vector <int> &from,
-        const std::vector <int> &to,
-        Rcpp::NumericVector &d);
-double calc_ss (const std::vector <EdgeComponent> &edges,
+template <typename T>
+void fill_edges (TreeDat <T> &tree,
+        const utils::IndexView &from,
+        const utils::IndexView &to,
+        const double *d,
+        const double *weights);
+template <typename T>
+double calc_ss (const std::vector <EdgeComponent <T> > &edges,
         const int cluster_num);
-double calc_covsum (const std::vector <EdgeComponent> &edges,
+template <typename T>
+double calc_covsum (const std::vector <EdgeComponent <T> > &edges,
         const int cluster_num);
-size_t cluster_size (const std::vector <EdgeComponent> &edges,
+template <typename T>
+size_t cluster_size (const std::vector <EdgeComponent <T> > &edges,
         const int cluster_num);
-std::unordered_set <int> build_one_tree (std::vector <EdgeComponent> &edges);
+template <typename T>
+std::unordered_set <int> build_one_tree (
+        std::vector <EdgeComponent <T> > &edges);
 
-TwoSS sum_component_ss (const std::vector <EdgeComponent> &edges,
-        const std::unordered_set <int> &tree_edges, const bool shortest);
-BestCut find_min_cut (const TreeDat &tree, const int cluster_num,
-        const bool shortest);
+// Cmp is the comparison policy, either policy::Shortest for distances, or
+// policy::Longest for covariances.
+template <typename T, typename Cmp>
+TwoSS sum_component_ss (const std::vector <EdgeComponent <T> > &edges,
+        const std::unordered_set <int> &tree_edges);
+// Cuts are only made where both resultant clusters satisfy `limits`.
+template <typename T, typename Cmp>
+BestCut find_min_cut (const TreeDat <T> &tree, const int cluster_num,
+        const Limits &limits);
+
+// Distances, `d`, are passed as raw pointers so that trees can also be cut
+// from worker threads, in which case `threaded` must be `true` to suppress all
+// calls to the R API, and errors are thrown as std::runtime_error. All
+// clusters satisfy `limits`, so the result has exactly `ncl` clusters unless
+// no cluster can be split any further, or unless `budget` expires, in which
+// case the clusters found so far are returned, and `budget.expired ()` is
+// `true`. The budget is only checked once the tree has been cut at least once,
+// so that results always have some clusters.
+template <typename T, typename Cmp>
+std::vector <int> cut_tree (const utils::IndexView &from,
+        const utils::IndexView &to, const double *d,
+        const int ncl, const Limits &limits, budget::Budget &budget,
+        const bool quiet, const bool threaded = false);
+
+// Targets for policy::dispatch
+struct CutTree {
+    template <typename T, typename Cmp>
+    static std::vector <int> run (const utils::IndexView &from,
+            const utils::IndexView &to, const double *d,
+            const int ncl, const Limits &limits, budget::Budget &budget,
+            const bool quiet) {
+        return cut_tree <T, Cmp> (from, to, d, ncl, limits, budget, quiet);
+    }
+};
+
+// Cut one tree for each column of the (nedges x nlayers) matrix of distances,
+// `d`, returning clusters in the same column-major layout. All layers share
+// the deadline of `budget`, and `partial` is filled with flags for each layer
+// of whether the budget expired before it was fully cut.
+struct CutTreeBatch {
+    template <typename T, typename Cmp>
+    static std::vector <int> run (const utils::IndexView &from,
+            const utils::IndexView &to, const double *d,
+            const size_t nlayers, const int ncl, const Limits &limits,
+            const budget::Budget &budget, std::vector <int> &partial,
+            const int nthreads);
+};
 
 } // end namespace cuttree
 
 Rcpp::IntegerVector rcpp_cut_tree (const Rcpp::DataFrame tree, const int ncl,
-        const bool shortest, const bool quiet);
+        const bool shortest, const int min_size,
+        const Rcpp::NumericVector weights, const double min_weight,
+        const double time_budget, const bool quiet,
+        const std::string precision);
+
+Rcpp::IntegerMatrix rcpp_cut_tree_batch (const Rcpp::DataFrame tree,
+        const Rcpp::NumericMatrix d, const int ncl, const bool shortest,
+        const int min_size, const Rcpp::NumericVector weights,
+        const double min_weight, const double time_budget,
+        const std::string precision, const int nthreads);
@@ -0,0 +1,571 @@
+#include "common.h"
+#include "delaunay.h"
+#include "threads.h"
+
+#include <numeric> // std::iota
+#include <queue>
+
+namespace {
+
+constexpr double TWO_PI = 2.0 * M_PI;
+
+// Twice the signed area of triangle (a, b, c), positive if counter-clockwise
+double cross (const double ax, const double ay, const double bx,
+        const double by, const double cx, const double cy) {
+    return (bx - ax) * (cy - ay) - (by - ay) * (cx - ax);
+}
+
+// Positive if (px, py) lies within the circumcircle of counter-clockwise
+// triangle (a, b, c)
+double in_circle (const double ax, const double ay, const double bx,
+        const double by, const double cx, const double cy,
+        const double px, const double py) {
+    const double dx = ax - px, dy = ay - py,
+          ex = bx - px, ey = by - py,
+          fx = cx - px, fy = cy - py;
+    const double ap = dx * dx + dy * dy,
+          bp = ex * ex + ey * ey,
+          cp = fx * fx + fy * fy;
+    return dx * (ey * cp - bp * fy) - dy * (ex * cp - bp * fx) +
+        ap * (ex * fy - ey * fx);
+}
+
+// Squared circumradius, or infinity for collinear points
+double circumradius2 (const double ax, const double ay, const double bx,
+        const double by, const double cx, const double cy) {
+    const double dx = bx - ax, dy = by - ay,
+          ex = cx - ax, ey = cy - ay;
+    const double bl = dx * dx + dy * dy,
+          cl = ex * ex + ey * ey,
+          d = 0.5 / (dx * ey - dy * ex);
+    const double x = (ey * bl - dy * cl) * d,
+          y = (dx * cl - ex * bl) * d;
+    const double r2 = x * x + y * y;
+    return std::isfinite (r2) ? r2 : INFINITE_DOUBLE;
+}
+
+void circumcentre (const double ax, const double ay, const double bx,
+        const double by, const double cx, const double cy,
+        double &x, double &y) {
+    const double dx = bx - ax, dy = by - ay,
+          ex = cx - ax, ey = cy - ay;
+    const double bl = dx * dx + dy * dy,
+          cl = ex * ex + ey * ey,
+          d = 0.5 / (dx * ey - dy * ex);
+    x = ax + (ey * bl - dy * cl) * d;
+    y = ay + (dx * cl - ex * bl) * d;
+}
+
+// Monotonic function of the angle of (dx, dy), in [0, 1)
+double pseudo_angle (const double dx, const double dy) {
+    if (dx == 0.0 && dy == 0.0) {
+        return 0.0;
+    }
+    const double p = dx / (std::fabs (dx) + std::fabs (dy));
+    return (dy > 0.0 ? 3.0 - p : 1.0 + p) / 4.0;
+}
+
+class Sweep {
+    const std::vector <double> &x, &y;
+    const size_t n;
+
+    std::vector <size_t> triangles, halfedges;
+    // Convex hull as a doubly-linked list of vertices, with `hull_tri` the
+    // half-edge of the triangle inside each hull edge
+    std::vector <size_t> hull_next, hull_prev, hull_tri, hull_hash;
+    size_t hull_start = 0;
+    double cx = 0.0, cy = 0.0;
+
+    std::vector <size_t> edge_stack;
+
+    size_t hash_key (const size_t i) const {
+        const size_t nh = hull_hash.size ();
+        const size_t k = static_cast <size_t> (std::floor (
+                    pseudo_angle (x [i] - cx, y [i] - cy) *
+                    static_cast <double> (nh)));
+        return k % nh;
+    }
+
+    void link (const size_t a, const size_t b) {
+        halfedges [a] = b;
+        if (b != delaunay::NONE) {
+            halfedges [b] = a;
+        }
+    }
+
+    size_t add_triangle (const size_t i0, const size_t i1, const size_t i2,
+            const size_t a, const size_t b, const size_t c) {
+        const size_t t = triangles.size ();
+        triangles.push_back (i0);
+        triangles.push_back (i1);
+        triangles.push_back (i2);
+        halfedges.resize (t + 3);
+        link (t, a);
+        link (t + 1, b);
+        link (t + 2, c);
+        return t;
+    }
+
+    size_t legalize (size_t a);
+
+    // Whether point `p` lies strictly outside hull edge (i, j)
+    bool visible (const size_t p, const size_t i, const size_t j) const {
+        return cross (x [i], y [i], x [j], y [j], x [p], y [p]) < 0.0;
+    }
+
+public:
+    Sweep (const std::vector <double> &x_in, const std::vector <double> &y_in)
+        : x (x_in), y (y_in), n (x_in.size ()) {}
+
+    delaunay::Triangulation run ();
+};
+
+// Flip the edge `a` and all subsequently affected edges until all are locally
+// Delaunay. The point opposite `a` must be the most recently inserted point,
+// and the half-edge returned is the edge from that point to the first vertex
+// of `a`, which may have moved to another triangle.
+size_t Sweep::legalize (size_t a) {
+
+    edge_stack.clear ();
+    size_t ar;
+
+    while (true) {
+        const size_t b = halfedges [a];
+        const size_t a0 = a - a % 3;
+        ar = a0 + (a + 2) % 3;
+
+        if (b == delaunay::NONE) {
+            if (edge_stack.empty ()) {
+                break;
+            }
+            a = edge_stack.back ();
+            edge_stack.pop_back ();
+            continue;
+        }
+
+        const size_t b0 = b - b % 3;
+        const size_t al = a0 + (a + 1) % 3;
+        const size_t bl = b0 + (b + 2) % 3;
+
+        const size_t p0 = triangles [ar];
+        const size_t pr = triangles [a];
+        const size_t pl = triangles [al];
+        const size_t p1 = triangles [bl];
+
+        const bool illegal = in_circle (x [p0], y [p0], x [pr], y [pr],
+                x [pl], y [pl], x [p1], y [p1]) > 0.0;
+
+        if (illegal) {
+            triangles [a] = p1;
+            triangles [b] = p0;
+
+            const size_t hbl = halfedges [bl];
+            // Edge swapped onto the hull
+            if (hbl == delaunay::NONE) {
+                size_t e = hull_start;
+                do {
+                    if (hull_tri [e] == bl) {
+                        hull_tri [e] = a;
+                        break;
+                    }
+                    e = hull_prev [e];
+                } while (e != hull_start);
+            }
+            link (a, hbl);
+            link (b, halfedges [ar]);
+            link (ar, bl);
+
+            edge_stack.push_back (b0 + (b + 1) % 3);
+        } else {
+            if (edge_stack.empty ()) {
+                break;
+            }
+            a = edge_stack.back ();
+            edge_stack.pop_back ();
+        }
+    }
+
+    return ar;
+}
+
+delaunay::Triangulation Sweep::run () {
+
+    delaunay::Triangulation res;
+    if (n < 3) {
+        return res;
+    }
+
+    double xmin = INFINITE_DOUBLE, xmax = -INFINITE_DOUBLE,
+           ymin = INFINITE_DOUBLE, ymax = -INFINITE_DOUBLE;
+    for (size_t i = 0; i < n; i++) {
+        xmin = std::min (xmin, x [i]);
+        xmax = std::max (xmax, x [i]);
+        ymin = std::min (ymin, y [i]);
+        ymax = std::max (ymax, y [i]);
+    }
+    const double mx = (xmin + xmax) / 2.0, my = (ymin + ymax) / 2.0;
+
+    // Seed triangle from the point nearest the centre, its nearest neighbour,
+    // and the point forming the smallest circumcircle with those two.
+    auto dist2 = [this] (const size_t i, const double px, const double py) {
+        const double dx = x [i] - px, dy = y [i] - py;
+        return dx * dx + dy * dy;
+    };
+    size_t i0 = 0, i1 = delaunay::NONE, i2 = delaunay::NONE;
+    double dmin = INFINITE_DOUBLE;
+    for (size_t i = 0; i < n; i++) {
+        const double d = dist2 (i, mx, my);
+        if (d < dmin) {
+            i0 = i;
+            dmin = d;
+        }
+    }
+    dmin = INFINITE_DOUBLE;
+    for (size_t i = 0; i < n; i++) {
+        const double d = dist2 (i, x [i0], y [i0]);
+        if (d > 0.0 && d < dmin) {
+            i1 = i;
+            dmin = d;
+        }
+    }
+    if (i1 == delaunay::NONE) {
+        return res;
+    }
+    double rmin = INFINITE_DOUBLE;
+    for (size_t i = 0; i < n; i++) {
+        if (i == i0 || i == i1) {
+            continue;
+        }
+        const double r = circumradius2 (x [i0], y [i0], x [i1], y [i1],
+                x [i], y [i]);
+        if (r < rmin) {
+            i2 = i;
+            rmin = r;
+        }
+    }
+    if (i2 == delaunay::NONE) {
+        return res;
+    }
+    if (cross (x [i0], y [i0], x [i1], y [i1], x [i2], y [i2]) < 0.0) {
+        std::swap (i1, i2);
+    }
+    circumcentre (x [i0], y [i0], x [i1], y [i1], x [i2], y [i2], cx, cy);
+
+    std::vector <double> dists (n);
+    for (size_t i = 0; i < n; i++) {
+        dists [i] = dist2 (i, cx, cy);
+    }
+    std::vector <size_t> ord (n);
+    std::iota (ord.begin (), ord.end (), 0);
+    std::sort (ord.begin (), ord.end (),
+            [&dists] (const size_t a, const size_t b) {
+                return dists [a] < dists [b] ||
+                    (dists [a] == dists [b] && a < b); });
+
+    const size_t hash_size = static_cast <size_t> (
+            std::ceil (std::sqrt (static_cast <double> (n))));
+    hull_next.assign (n, delaunay::NONE);
+    hull_prev.assign (n, delaunay::NONE);
+    hull_tri.assign (n, delaunay::NONE);
+    hull_hash.assign (hash_size, delaunay::NONE);
+
+    hull_start = i0;
+    hull_next [i0] = hull_prev [i2] = i1;
+    hull_next [i1] = hull_prev [i0] = i2;
+    hull_next [i2] = hull_prev [i1] = i0;
+    hull_tri [i0] = 0;
+    hull_tri [i1] = 1;
+    hull_tri [i2] = 2;
+    hull_hash [hash_key (i0)] = i0;
+    hull_hash [hash_key (i1)] = i1;
+    hull_hash [hash_key (i2)] = i2;
+
+    const size_t max_tri = 2 * n - 5;
+    triangles.reserve (max_tri * 3);
+    halfedges.reserve (max_tri * 3);
+    add_triangle (i0, i1, i2, delaunay::NONE, delaunay::NONE,
+            delaunay::NONE);
+
+    size_t prev = delaunay::NONE;
+    for (auto i: ord) {
+        // Skip duplicated points
+        const bool dup = prev != delaunay::NONE &&
+            x [i] == x [prev] && y [i] == y [prev];
+        prev = i;
+        if (dup || i == i0 || i == i1 || i == i2) {
+            continue;
+        }
+
+        // Find a visible edge of the hull, starting from the hull vertex
+        // nearest in angle about the centre.
+        size_t start = delaunay::NONE;
+        const size_t key = hash_key (i);
+        for (size_t j = 0; j < hash_size; j++) {
+            start = hull_hash [(key + j) % hash_size];
+            if (start != delaunay::NONE && start != hull_next [start]) {
+                break;
+            }
+        }
+        start = hull_prev [start];
+        size_t e = start;
+        bool found = true;
+        while (!visible (i, e, hull_next [e])) {
+            e = hull_next [e];
+            if (e == start) {
+                found = false;
+                break;
+            }
+        }
+        // Points within rounding error of the hull are not triangulated
+        if (!found) {
+            continue;
+        }
+
+        size_t t = add_triangle (e, i, hull_next [e], delaunay::NONE,
+                delaunay::NONE, hull_tri [e]);
+        hull_tri [i] = legalize (t + 2);
+        hull_tri [e] = t;
+
+        // Connect to all further visible edges forwards along the hull ...
+        size_t nx = hull_next [e];
+        size_t q = hull_next [nx];
+        while (visible (i, nx, q)) {
+            t = add_triangle (nx, i, q, hull_tri [i], delaunay::NONE,
+                    hull_tri [nx]);
+            hull_tri [i] = legalize (t + 2);
+            hull_next [nx] = nx; // removed from hull
+            nx = q;
+            q = hull_next [nx];
+        }
+
+        // ... and backwards
+        if (e == start) {
+            q = hull_prev [e];
+            while (visible (i, q, e)) {
+                t = add_triangle (q, i, e, delaunay::NONE, hull_tri [e],
+                        hull_tri [q]);
+                legalize (t + 2);
+                hull_tri [q] = t;
+                hull_next [e] = e;
+                e = q;
+                q = hull_prev [e];
+            }
+        }
+
+        hull_start = hull_prev [i] = e;
+        hull_next [e] = hull_prev [nx] = i;
+        hull_next [i] = nx;
+
+        hull_hash [hash_key (i)] = i;
+        hull_hash [hash_key (e)] = e;
+    }
+
+    res.triangles.swap (triangles);
+    res.halfedges.swap (halfedges);
+
+    return res;
+}
+
+} // end anonymous namespace
+
+delaunay::Triangulation delaunay::triangulate (const std::vector <double> &x,
+        const std::vector <double> &y) {
+
+    Sweep sweep (x, y);
+    return sweep.run ();
+}
+
+std::vector <std::vector <size_t> > delaunay::alpha_rings (
+        const std::vector <double> &x, const std::vector <double> &y,
+        const delaunay::Triangulation &tri, const double alpha) {
+
+    const std::vector <size_t> &tr = tri.triangles, &he = tri.halfedges;
+    const size_t ntri = tr.size () / 3;
+    const double alpha2 = alpha * alpha;
+
+    auto too_big = [&] (const size_t t) {
+        const size_t a = tr [3 * t], b = tr [3 * t + 1], c = tr [3 * t + 2];
+        return circumradius2 (x [a], y [a], x [b], y [b], x [c], y [c]) >=
+            alpha2;
+    };
+
+    // Remove large triangles inwards from the convex hull
+    std::vector <bool> removed (ntri, false);
+    std::queue <size_t> q;
+    for (size_t e = 0; e < he.size (); e++) {
+        const size_t t = e / 3;
+        if (he [e] == delaunay::NONE && !removed [t] && too_big (t)) {
+            removed [t] = true;
+            q.push (t);
+        }
+    }
+    while (!q.empty ()) {
+        const size_t t = q.front ();
+        q.pop ();
+        for (size_t k = 0; k < 3; k++) {
+            const size_t o = he [3 * t + k];
+            if (o == delaunay::NONE) {
+                continue;
+            }
+            const size_t t2 = o / 3;
+            if (!removed [t2] && too_big (t2)) {
+                removed [t2] = true;
+                q.push (t2);
+            }
+        }
+    }
+
+    // Boundary half-edges of the remaining triangles, grouped by first vertex
+    std::unordered_map <size_t, std::vector <size_t> > out_edges;
+    std::vector <size_t> boundary;
+    for (size_t e = 0; e < he.size (); e++) {
+        if (removed [e / 3]) {
+            continue;
+        }
+        if (he [e] == delaunay::NONE || removed [he [e] / 3]) {
+            boundary.push_back (e);
+            out_edges [tr [e]].push_back (e);
+        }
+    }
+
+    auto edge_end = [&tr] (const size_t e) {
+        return tr [e - e % 3 + (e + 1) % 3];
+    };
+
+    // Trace rings, turning at each vertex onto the first boundary edge
+    // clockwise from the incoming edge, so that rings of hulls which touch at
+    // single vertices are traced separately.
+    std::unordered_set <size_t> used;
+    std::vector <std::vector <size_t> > rings;
+    for (auto e0: boundary) {
+        if (used.find (e0) != used.end ()) {
+            continue;
+        }
+        std::vector <size_t> ring;
+        size_t e = e0;
+        while (true) {
+            used.emplace (e);
+            ring.push_back (tr [e]);
+            const size_t u = tr [e], v = edge_end (e);
+            const std::vector <size_t> &cands = out_edges [v];
+            size_t next = cands.front ();
+            if (cands.size () > 1) {
+                const double a_in = std::atan2 (y [u] - y [v], x [u] - x [v]);
+                double best = INFINITE_DOUBLE;
+                for (auto c: cands) {
+                    const size_t w = edge_end (c);
+                    double a = a_in - std::atan2 (y [w] - y [v], x [w] - x [v]);
+                    while (a <= 0.0) {
+                        a += TWO_PI;
+                    }
+                    if (a < best) {
+                        best = a;
+                        next = c;
+                    }
+                }
+            }
+            if (next == e0 || used.find (next) != used.end ()) {
+                break;
+            }
+            e = next;
+        }
+        rings.push_back (ring);
+    }
+
+    return rings;
+}
+
+//' rcpp_ahulls
+//'
+//' Alpha hulls of each cluster of points, from Delaunay triangulations.
+//'
+//' @param x, y Coordinates of points
+//' @param cluster Cluster number of each point, with NA for unclustered points
+//' @param alpha Radius of alpha hulls
+//' @param nthreads Number of threads, with values <= 0 using all available
+//'
+//' @return `data.frame` of (id, ring, x, y), where `id` is the cluster number
+//' and `ring` a unique number for each ring of coordinates bounding a cluster.
+//' Clusters of fewer than three points, or of collinear points, have no rings.
+//' @noRd
+// [[Rcpp::export]]
+Rcpp::DataFrame rcpp_ahulls (
+        const Rcpp::NumericVector x,
+        const Rcpp::NumericVector y,
+        const Rcpp::IntegerVector cluster,
+        const double alpha,
+        const int nthreads) {
+
+    if (x.size () != y.size () || x.size () != cluster.size ()) {
+        Rcpp::stop ("x, y, and cluster must have the same length");
+    }
+    if (!(alpha > 0.0)) {
+        Rcpp::stop ("alpha must be positive");
+    }
+
+    std::map <int, std::vector <size_t> > cl_map;
+    for (R_xlen_t i = 0; i < x.size (); i++) {
+        if (cluster [i] == NA_INTEGER) {
+            continue;
+        }
+        if (!std::isfinite (x [i]) || !std::isfinite (y [i])) {
+            Rcpp::stop ("Coordinates must all be finite");
+        }
+        cl_map [cluster [i]].push_back (static_cast <size_t> (i));
+    }
+    std::vector <int> cl_ids;
+    std::vector <std::vector <size_t> > cl_nodes;
+    for (auto cl: cl_map) {
+        if (cl.second.size () > 2) {
+            cl_ids.push_back (cl.first);
+            cl_nodes.push_back (cl.second);
+        }
+    }
+
+    const size_t ncl = cl_ids.size ();
+    std::vector <std::vector <std::vector <size_t> > > rings (ncl);
+    const double *xp = x.begin (), *yp = y.begin ();
+
+    threads::parallel_for_each (ncl, nthreads, [&] (const size_t i) {
+        const std::vector <size_t> &nodes = cl_nodes [i];
+        std::vector <double> xi (nodes.size ()), yi (nodes.size ());
+        for (size_t j = 0; j < nodes.size (); j++) {
+            xi [j] = xp [nodes [j]];
+            yi [j] = yp [nodes [j]];
+        }
+        const delaunay::Triangulation tri = delaunay::triangulate (xi, yi);
+        rings [i] = delaunay::alpha_rings (xi, yi, tri, alpha);
+    });
+
+    size_t len = 0;
+    for (const auto &r: rings) {
+        for (const auto &ri: r) {
+            len += ri.size ();
+        }
+    }
+    const R_xlen_t m = static_cast <R_xlen_t> (len);
+    Rcpp::IntegerVector id (m), ring (m);
+    Rcpp::NumericVector rx (m), ry (m);
+    R_xlen_t pos = 0;
+    int ring_num = 0;
+    for (size_t i = 0; i < ncl; i++) {
+        for (const auto &ri: rings [i]) {
+            ring_num++;
+            for (auto j: ri) {
+                const size_t node = cl_nodes [i] [j];
+                id [pos] = cl_ids [i];
+                ring [pos] = ring_num;
+                rx [pos] = xp [node];
+                ry [pos] = yp [node];
+                pos++;
+            }
+        }
+    }
+
+    return Rcpp::DataFrame::create (
+        Rcpp::Named ("id") = id,
+        Rcpp::Named ("ring") = ring,
+        Rcpp::Named ("x") = rx,
+        Rcpp::Named ("y") = ry,
+        Rcpp::_["stringsAsFactors"] = false);
+}
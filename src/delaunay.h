@@ -0,0 +1,50 @@
+#pragma once
+
+// --------- DELAUNAY TRIANGULATION AND ALPHA HULLS ----------------
+
+/* Delaunay triangulations of planar points are constructed here with a
+ * sweep-hull algorithm: points are inserted in order of distance from the
+ * circumcentre of an initial triangle, so that each lies outside the convex
+ * hull of all previous points, and is connected to all hull edges which it can
+ * see. Edges are then flipped until all triangles are locally Delaunay. Hull
+ * edges visible from each new point are found through a hash of the angles of
+ * hull vertices about the centre, so that insertion is close to constant time.
+ *
+ * Triangles are stored as triplets of vertex indices in counter-clockwise
+ * order, and each half-edge, `e`, runs from `triangles [e]` to the next vertex
+ * of its triangle, with `halfedges [e]` the opposite half-edge of the adjacent
+ * triangle, or NONE on the convex hull.
+ *
+ * Alpha hulls are then the unions of all triangles with circumradii less than
+ * `alpha`, as for the alpha shapes of the alphahull package, except that only
+ * triangles connected to the exterior are removed, so that hulls have no
+ * holes. Boundaries are returned as counter-clockwise rings of vertices, with
+ * hulls which touch at single vertices split into separate rings.
+ */
+
+namespace delaunay {
+
+constexpr size_t NONE = std::numeric_limits <size_t>::max ();
+
+struct Triangulation {
+    std::vector <size_t> triangles, halfedges;
+};
+
+// Triangulation of points with coordinates (x, y). Duplicated points are
+// triangulated only once, and the result is empty if all points are collinear.
+Triangulation triangulate (const std::vector <double> &x,
+        const std::vector <double> &y);
+
+// Boundary rings of the alpha hull of a triangulation
+std::vector <std::vector <size_t> > alpha_rings (const std::vector <double> &x,
+        const std::vector <double> &y, const Triangulation &tri,
+        const double alpha);
+
+} // end namespace delaunay
+
+Rcpp::DataFrame rcpp_ahulls (
+        const Rcpp::NumericVector x,
+        const Rcpp::NumericVector y,
+        const Rcpp::IntegerVector cluster,
+        const double alpha,
+        const int nthreads);
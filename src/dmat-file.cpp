@@ -0,0 +1,180 @@
+#include "common.h"
+#include "utils.h"
+#include "dmat-file.h"
+
+#include <cstdio>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+#ifndef _WIN32
+
+// Read-only memory map of an entire file, released on destruction so that
+// Rcpp::stop can be called at any point.
+struct MappedFile {
+    int fd = -1;
+    void *addr = MAP_FAILED;
+    size_t size = 0;
+
+    explicit MappedFile (const std::string &path) {
+        fd = open (path.c_str (), O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        struct stat st;
+        if (fstat (fd, &st) != 0) {
+            return;
+        }
+        size = static_cast <size_t> (st.st_size);
+        if (size == 0) {
+            return;
+        }
+        addr = mmap (nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr != MAP_FAILED) {
+            // Edges are gathered in arbitrary order, so read-ahead is wasted
+            madvise (addr, size, MADV_RANDOM);
+        }
+    }
+
+    ~MappedFile () {
+        if (addr != MAP_FAILED) {
+            munmap (addr, size);
+        }
+        if (fd >= 0) {
+            close (fd);
+        }
+    }
+
+    bool ok () const {
+        return addr != MAP_FAILED;
+    }
+};
+
+#else
+
+struct OpenFile {
+    FILE *f = nullptr;
+
+    explicit OpenFile (const std::string &path) {
+        f = std::fopen (path.c_str (), "rb");
+    }
+
+    ~OpenFile () {
+        if (f != nullptr) {
+            std::fclose (f);
+        }
+    }
+};
+
+#endif
+
+} // end anonymous namespace
+
+template <typename T>
+void dmat_file::gather (const std::string &path,
+        const size_t n,
+        const bool byrow,
+        const Rcpp::IntegerVector &from,
+        const Rcpp::IntegerVector &to,
+        Rcpp::NumericVector &d) {
+
+    const size_t nedges = static_cast <size_t> (from.size ());
+    const size_t nbytes = n * n * sizeof (T);
+
+#ifndef _WIN32
+
+    MappedFile mf (path);
+    if (!mf.ok ()) {
+        Rcpp::stop ("Unable to memory-map file [" + path + "]");
+    }
+    if (mf.size != nbytes) {
+        Rcpp::stop ("File [" + path + "] has size " +
+                std::to_string (mf.size) + " bytes, but n = " +
+                std::to_string (n) + " requires " +
+                std::to_string (nbytes));
+    }
+    const T *data = static_cast <const T *> (mf.addr);
+
+    for (size_t k = 0; k < nedges; k++) {
+        const int ki = static_cast <int> (k); // int for Rcpp index
+        const size_t i = static_cast <size_t> (from [ki] - 1),
+                     j = static_cast <size_t> (to [ki] - 1);
+        d [ki] = static_cast <double> (data [offset (i, j, n, byrow)]);
+    }
+
+#else
+
+    OpenFile of (path);
+    if (of.f == nullptr) {
+        Rcpp::stop ("Unable to open file [" + path + "]");
+    }
+
+    // Visit entries in order of file position, so each seek is forward only.
+    std::vector <std::pair <size_t, size_t> > offsets (nedges);
+    for (size_t k = 0; k < nedges; k++) {
+        const int ki = static_cast <int> (k);
+        const size_t i = static_cast <size_t> (from [ki] - 1),
+                     j = static_cast <size_t> (to [ki] - 1);
+        offsets [k] = std::make_pair (offset (i, j, n, byrow), k);
+    }
+    std::sort (offsets.begin (), offsets.end ());
+
+    T value;
+    for (auto o: offsets) {
+        const long long pos = static_cast <long long> (o.first * sizeof (T));
+        if (_fseeki64 (of.f, pos, SEEK_SET) != 0 ||
+                std::fread (&value, sizeof (T), 1, of.f) != 1) {
+            Rcpp::stop ("Unable to read entry from file [" + path + "]");
+        }
+        d [static_cast <int> (o.second)] = static_cast <double> (value);
+    }
+
+#endif
+}
+
+//' rcpp_dmat_file_edges
+//'
+//' Gather the entries of a file-backed dissimilarity matrix at the positions
+//' of a set of edges.
+//'
+//' @param path Path to binary file of n * n values
+//' @param type Either "double" or "single"
+//' @param byrow If `TRUE`, values are stored in row-major order
+//' @param from, to 1-indexed vertex numbers of edges
+//'
+//' @return Vector of dissimilarities, one for each edge
+//' @noRd
+// [[Rcpp::export]]
+Rcpp::NumericVector rcpp_dmat_file_edges (
+        const std::string path,
+        const int n,
+        const std::string type,
+        const bool byrow,
+        const Rcpp::IntegerVector from,
+        const Rcpp::IntegerVector to) {
+
+    if (n <= 0) {
+        Rcpp::stop ("n must be positive");
+    }
+    const size_t nu = static_cast <size_t> (n);
+    for (int k = 0; k < from.size (); k++) {
+        if (from [k] < 1 || from [k] > n || to [k] < 1 || to [k] > n) {
+            Rcpp::stop ("edge indices must be between 1 and n");
+        }
+    }
+
+    Rcpp::NumericVector d (from.size ());
+    if (utils::strfound (type, "single")) {
+        dmat_file::gather <float> (path, nu, byrow, from, to, d);
+    } else {
+        dmat_file::gather <double> (path, nu, byrow, from, to, d);
+    }
+
+    return d;
+}
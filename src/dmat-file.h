@@ -0,0 +1,36 @@
+#pragma once
+
+// --------- FILE-BACKED DISSIMILARITY MATRICES ----------------
+
+/* Dense n-by-n dissimilarity matrices stored on disk as raw binary values,
+ * either `float` or `double`, in either row- or column-major order. The files
+ * are memory-mapped where possible (all POSIX systems), so that only the pages
+ * holding the requested entries are ever read into memory. On other systems
+ * entries are read individually with sorted, buffered seeks.
+ */
+
+namespace dmat_file {
+
+// Offset (in elements) into the file of entry (i, j), both 0-indexed.
+inline size_t offset (const size_t i, const size_t j, const size_t n,
+        const bool byrow) {
+    return byrow ? i * n + j : j * n + i;
+}
+
+template <typename T>
+void gather (const std::string &path,
+        const size_t n,
+        const bool byrow,
+        const Rcpp::IntegerVector &from,
+        const Rcpp::IntegerVector &to,
+        Rcpp::NumericVector &d);
+
+} // end namespace dmat_file
+
+Rcpp::NumericVector rcpp_dmat_file_edges (
+        const std::string path,
+        const int n,
+        const std::string type,
+        const bool byrow,
+        const Rcpp::IntegerVector from,
+        const Rcpp::IntegerVector to);
@@ -0,0 +1,278 @@
+#include "common.h"
+#include "utils.h"
+#include "threads.h"
+#include "edge-dists.h"
+
+edge_dists::RowMatrix edge_dists::row_major (const Rcpp::NumericMatrix &x) {
+    edge_dists::RowMatrix res;
+    res.nrow = static_cast <size_t> (x.nrow ());
+    res.ncol = static_cast <size_t> (x.ncol ());
+    res.values.resize (res.nrow * res.ncol);
+
+    // R matrices are column-major, so this reads sequentially from x
+    const double *xp = x.begin ();
+    for (size_t j = 0; j < res.ncol; j++) {
+        for (size_t i = 0; i < res.nrow; i++) {
+            res.values [i * res.ncol + j] = xp [j * res.nrow + i];
+        }
+    }
+
+    return res;
+}
+
+double edge_dists::euclidean (const double *a, const double *b,
+        const size_t p) {
+    double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+    size_t k = 0;
+    for (; k + 4 <= p; k += 4) {
+        const double d0 = a [k] - b [k],
+                     d1 = a [k + 1] - b [k + 1],
+                     d2 = a [k + 2] - b [k + 2],
+                     d3 = a [k + 3] - b [k + 3];
+        s0 += d0 * d0;
+        s1 += d1 * d1;
+        s2 += d2 * d2;
+        s3 += d3 * d3;
+    }
+    for (; k < p; k++) {
+        const double dk = a [k] - b [k];
+        s0 += dk * dk;
+    }
+    return std::sqrt ((s0 + s1) + (s2 + s3));
+}
+
+double edge_dists::manhattan (const double *a, const double *b,
+        const size_t p) {
+    double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+    size_t k = 0;
+    for (; k + 4 <= p; k += 4) {
+        s0 += std::fabs (a [k] - b [k]);
+        s1 += std::fabs (a [k + 1] - b [k + 1]);
+        s2 += std::fabs (a [k + 2] - b [k + 2]);
+        s3 += std::fabs (a [k + 3] - b [k + 3]);
+    }
+    for (; k < p; k++) {
+        s0 += std::fabs (a [k] - b [k]);
+    }
+    return (s0 + s1) + (s2 + s3);
+}
+
+double edge_dists::dot (const double *a, const double *b, const size_t p) {
+    double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+    size_t k = 0;
+    for (; k + 4 <= p; k += 4) {
+        s0 += a [k] * b [k];
+        s1 += a [k + 1] * b [k + 1];
+        s2 += a [k + 2] * b [k + 2];
+        s3 += a [k + 3] * b [k + 3];
+    }
+    for (; k < p; k++) {
+        s0 += a [k] * b [k];
+    }
+    return (s0 + s1) + (s2 + s3);
+}
+
+void edge_dists::standardise (edge_dists::RowMatrix &x, const bool scale) {
+    const size_t p = x.ncol;
+    for (size_t i = 0; i < x.nrow; i++) {
+        double *xi = x.values.data () + i * p;
+        double mn = 0.0;
+        for (size_t k = 0; k < p; k++) {
+            mn += xi [k];
+        }
+        mn /= static_cast <double> (p);
+        double ss = 0.0;
+        for (size_t k = 0; k < p; k++) {
+            xi [k] -= mn;
+            ss += xi [k] * xi [k];
+        }
+        if (scale) {
+            // Constant series have undefined correlations, as for stats::cor
+            const double s = ss > 0.0 ? 1.0 / std::sqrt (ss) : NA_REAL;
+            for (size_t k = 0; k < p; k++) {
+                xi [k] *= s;
+            }
+        }
+    }
+}
+
+void edge_dists::check_edges (const Rcpp::IntegerVector &from,
+        const Rcpp::IntegerVector &to,
+        const int n) {
+    if (from.size () != to.size ()) {
+        Rcpp::stop ("from and to must have the same length");
+    }
+    for (int k = 0; k < from.size (); k++) {
+        if (from [k] < 1 || from [k] > n || to [k] < 1 || to [k] > n) {
+            Rcpp::stop ("edge indices must be between 1 and the number of "
+                    "rows of the input data");
+        }
+    }
+}
+
+//' rcpp_feature_edges
+//'
+//' Calculate dissimilarities between feature vectors only along the edges of
+//' a contiguity graph.
+//'
+//' @param x Numeric matrix of features, one row for each point
+//' @param metric Either "euclidean" or "manhattan"
+//' @param from, to 1-indexed vertex numbers of edges
+//'
+//' @return Vector of dissimilarities, one for each edge
+//' @noRd
+// [[Rcpp::export]]
+Rcpp::NumericVector rcpp_feature_edges (
+        const Rcpp::NumericMatrix x,
+        const std::string metric,
+        const Rcpp::IntegerVector from,
+        const Rcpp::IntegerVector to) {
+
+    edge_dists::check_edges (from, to, x.nrow ());
+
+    const edge_dists::RowMatrix xr = edge_dists::row_major (x);
+    const bool manhattan = utils::strfound (metric, "manhattan");
+
+    Rcpp::NumericVector d (from.size ());
+    for (int k = 0; k < from.size (); k++) {
+        const double *a = xr.row (static_cast <size_t> (from [k] - 1)),
+                     *b = xr.row (static_cast <size_t> (to [k] - 1));
+        if (manhattan) {
+            d [k] = edge_dists::manhattan (a, b, xr.ncol);
+        } else {
+            d [k] = edge_dists::euclidean (a, b, xr.ncol);
+        }
+    }
+
+    return d;
+}
+
+//' rcpp_timeseries_edges
+//'
+//' Calculate Pearson correlations or covariances between time series only
+//' along the edges of a contiguity graph.
+//'
+//' @param x Numeric matrix of time series, one row for each point
+//' @param method Either "correlation" or "covariance"
+//' @param from, to 1-indexed vertex numbers of edges
+//' @param nthreads Number of threads, with values <= 0 using all available
+//'
+//' @return Vector of correlations or covariances, one for each edge
+//' @noRd
+// [[Rcpp::export]]
+Rcpp::NumericVector rcpp_timeseries_edges (
+        const Rcpp::NumericMatrix x,
+        const std::string method,
+        const Rcpp::IntegerVector from,
+        const Rcpp::IntegerVector to,
+        const int nthreads) {
+
+    edge_dists::check_edges (from, to, x.nrow ());
+    if (x.ncol () < 2) {
+        Rcpp::stop ("time series must have at least 2 observations");
+    }
+
+    const bool correlation = utils::strfound (method, "correlation");
+    edge_dists::RowMatrix xr = edge_dists::row_major (x);
+    edge_dists::standardise (xr, correlation);
+    const double denom = correlation ? 1.0 :
+        static_cast <double> (xr.ncol - 1);
+
+    // Copy inputs to plain vectors so that worker threads never touch R memory
+    const std::vector <int> fromv (from.begin (), from.end ()),
+                            tov (to.begin (), to.end ());
+    std::vector <double> res (fromv.size ());
+
+    threads::parallel_for (fromv.size (), nthreads,
+            [&] (const size_t begin, const size_t end) {
+                for (size_t k = begin; k < end; k++) {
+                    const double *a = xr.row (
+                                        static_cast <size_t> (fromv [k] - 1)),
+                                 *b = xr.row (
+                                        static_cast <size_t> (tov [k] - 1));
+                    res [k] = edge_dists::dot (a, b, xr.ncol) / denom;
+                }
+            });
+
+    return Rcpp::wrap (res);
+}
+
+//' rcpp_kernel_edges
+//'
+//' Evaluate a user-supplied, compiled dissimilarity kernel only along the
+//' edges of a contiguity graph. The kernel is evaluated once for each unique
+//' edge, and results re-used for any duplicates (including reversed edges if
+//' `symmetric`).
+//'
+//' @param kernel External pointer to an `scl_kernel_t` function pointer
+//' @param n Number of points
+//' @param from, to 1-indexed vertex numbers of edges
+//' @param symmetric If `TRUE`, kernel(i, j) is presumed equal to kernel(j, i)
+//' @param nthreads Number of threads, with values <= 0 using all available
+//'
+//' @return Vector of dissimilarities, one for each edge
+//' @noRd
+// [[Rcpp::export]]
+Rcpp::NumericVector rcpp_kernel_edges (
+        SEXP kernel,
+        const int n,
+        const Rcpp::IntegerVector from,
+        const Rcpp::IntegerVector to,
+        const bool symmetric,
+        const int nthreads) {
+
+    edge_dists::check_edges (from, to, n);
+
+    Rcpp::XPtr <scl_kernel_t> xp (kernel);
+    if (xp.get () == nullptr || *xp == nullptr) {
+        Rcpp::stop ("kernel must be an external pointer to a function");
+    }
+    const scl_kernel_t fn = *xp;
+
+    // Unique (0-indexed) edges, each evaluated only once
+    typedef std::pair <int, int> edge_t;
+    const size_t nedges = static_cast <size_t> (from.size ());
+    std::vector <edge_t> edges (nedges);
+    for (size_t k = 0; k < nedges; k++) {
+        const int ki = static_cast <int> (k); // int for Rcpp index
+        int i = from [ki] - 1, j = to [ki] - 1;
+        if (symmetric && j < i) {
+            std::swap (i, j);
+        }
+        edges [k] = std::make_pair (i, j);
+    }
+    std::vector <edge_t> unique_edges (edges);
+    std::sort (unique_edges.begin (), unique_edges.end ());
+    unique_edges.erase (std::unique (unique_edges.begin (),
+                unique_edges.end ()), unique_edges.end ());
+
+    // Kernels are user code, which may throw. Exceptions are caught for each
+    // of the contiguous ranges of parallel_for, one per thread, and passed to R
+    // once all threads have been joined.
+    const size_t nu = unique_edges.size (),
+          nt = std::max (threads::num_threads (nthreads, nu),
+                  static_cast <size_t> (1)),
+          chunk = std::max ((nu + nt - 1) / nt, static_cast <size_t> (1));
+    std::vector <double> cache (nu);
+    threads::Errors errors (nt);
+    threads::parallel_for (nu, nthreads,
+            [&] (const size_t begin, const size_t end) {
+                errors.run (begin / chunk, [&] () {
+                    for (size_t k = begin; k < end; k++) {
+                        cache [k] = fn (unique_edges [k].first,
+                                unique_edges [k].second);
+                    }
+                });
+            });
+    errors.stop ("Kernel failed in thread ");
+
+    Rcpp::NumericVector d (from.size ());
+    for (size_t k = 0; k < nedges; k++) {
+        auto it = std::lower_bound (unique_edges.begin (),
+                unique_edges.end (), edges [k]);
+        d [static_cast <int> (k)] = cache [static_cast <size_t> (
+                std::distance (unique_edges.begin (), it))];
+    }
+
+    return d;
+}
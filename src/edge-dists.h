@@ -0,0 +1,64 @@
+#pragma once
+
+// --------- PER-EDGE DISSIMILARITIES ----------------
+
+/* Native kernels which calculate dissimilarities only along the edges of a
+ * contiguity graph, rather than requiring a full n-by-n matrix. Input data are
+ * copied once into row-major storage, so that the values for each point are
+ * contiguous in memory, and each kernel is a single pass over two such rows.
+ * Inner loops use several independent accumulators, allowing compilers to
+ * vectorise them.
+ */
+
+// User-supplied dissimilarity kernels, passed from R as external pointers to
+// functions of this type, called with 0-indexed point numbers.
+typedef double (*scl_kernel_t) (int, int);
+
+namespace edge_dists {
+
+// Row-major copy of an (n x p) R matrix
+struct RowMatrix {
+    size_t nrow, ncol;
+    std::vector <double> values;
+
+    const double * row (const size_t i) const {
+        return values.data () + i * ncol;
+    }
+};
+
+RowMatrix row_major (const Rcpp::NumericMatrix &x);
+
+double euclidean (const double *a, const double *b, const size_t p);
+double manhattan (const double *a, const double *b, const size_t p);
+double dot (const double *a, const double *b, const size_t p);
+
+// Centre each row of a time-series matrix, and also scale to unit norm if
+// `scale`, so that dot products of rows give correlations.
+void standardise (RowMatrix &x, const bool scale);
+
+void check_edges (const Rcpp::IntegerVector &from,
+        const Rcpp::IntegerVector &to,
+        const int n);
+
+} // end namespace edge_dists
+
+Rcpp::NumericVector rcpp_kernel_edges (
+        SEXP kernel,
+        const int n,
+        const Rcpp::IntegerVector from,
+        const Rcpp::IntegerVector to,
+        const bool symmetric,
+        const int nthreads);
+
+Rcpp::NumericVector rcpp_timeseries_edges (
+        const Rcpp::NumericMatrix x,
+        const std::string method,
+        const Rcpp::IntegerVector from,
+        const Rcpp::IntegerVector to,
+        const int nthreads);
+
+Rcpp::NumericVector rcpp_feature_edges (
+        const Rcpp::NumericMatrix x,
+        const std::string metric,
+        const Rcpp::IntegerVector from,
+        const Rcpp::IntegerVector to);
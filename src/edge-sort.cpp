@@ -0,0 +1,239 @@
+#include "common.h"
+#include "edge-sort.h"
+#include "scl-io.h"
+
+#include <memory> // std::unique_ptr
+#include <queue>
+
+namespace {
+
+// Sort by distance, with ties in column-major order of (from, to)
+struct EdgeOrder {
+    size_t n;
+    bool shortest;
+
+    bool operator() (const edge_sort::Edge &a, const edge_sort::Edge &b) const {
+        if (a.d != b.d) {
+            return shortest ? a.d < b.d : a.d > b.d;
+        }
+        const size_t ka = static_cast <size_t> (a.from) +
+                static_cast <size_t> (a.to) * n,
+            kb = static_cast <size_t> (b.from) +
+                static_cast <size_t> (b.to) * n;
+        return ka < kb;
+    }
+};
+
+void write_edges (const std::string &path,
+        const std::vector <edge_sort::Edge> &edges) {
+    scl_io::File file (path, "wb");
+    if (file.f == nullptr) {
+        Rcpp::stop ("Unable to open temporary file [" + path + "]");
+    }
+    if (std::fwrite (edges.data (), sizeof (edge_sort::Edge), edges.size (),
+                file.f) != edges.size ()) {
+        Rcpp::stop ("Unable to write to temporary file [" + path + "]");
+    }
+}
+
+// Buffered sequential reader of one sorted run
+struct RunReader {
+    scl_io::File file;
+    std::vector <edge_sort::Edge> buf;
+    size_t pos = 0, n = 0;
+
+    explicit RunReader (const std::string &path) :
+        file (path, "rb"), buf (edge_sort::BUFFER_EDGES) {
+        if (file.f == nullptr) {
+            Rcpp::stop ("Unable to open temporary file [" + path + "]");
+        }
+    }
+
+    bool next (edge_sort::Edge &e) {
+        if (pos == n) {
+            n = std::fread (buf.data (), sizeof (edge_sort::Edge), buf.size (),
+                    file.f);
+            pos = 0;
+            if (n == 0) {
+                return false;
+            }
+        }
+        e = buf [pos++];
+        return true;
+    }
+};
+
+void merge_runs (const std::vector <std::string> &runs,
+        const std::string &path, const EdgeOrder &order) {
+
+    std::vector <std::unique_ptr <RunReader> > readers;
+    for (auto r: runs) {
+        readers.emplace_back (new RunReader (r));
+    }
+
+    typedef std::pair <edge_sort::Edge, size_t> QueueEntry;
+    auto cmp = [&order] (const QueueEntry &a, const QueueEntry &b) {
+        return order (b.first, a.first);
+    };
+    std::priority_queue <QueueEntry, std::vector <QueueEntry>, decltype (cmp) >
+        queue (cmp);
+
+    edge_sort::Edge e;
+    for (size_t i = 0; i < readers.size (); i++) {
+        if (readers [i]->next (e)) {
+            queue.push (std::make_pair (e, i));
+        }
+    }
+
+    scl_io::File file (path, "wb");
+    if (file.f == nullptr) {
+        Rcpp::stop ("Unable to open temporary file [" + path + "]");
+    }
+    std::vector <edge_sort::Edge> out;
+    out.reserve (edge_sort::BUFFER_EDGES);
+    bool ok = true;
+
+    while (!queue.empty () && ok) {
+        const QueueEntry top = queue.top ();
+        queue.pop ();
+        out.push_back (top.first);
+        if (out.size () == edge_sort::BUFFER_EDGES) {
+            ok = std::fwrite (out.data (), sizeof (edge_sort::Edge),
+                    out.size (), file.f) == out.size ();
+            out.clear ();
+        }
+        if (readers [top.second]->next (e)) {
+            queue.push (std::make_pair (e, top.second));
+        }
+    }
+    if (ok && !out.empty ()) {
+        ok = std::fwrite (out.data (), sizeof (edge_sort::Edge), out.size (),
+                file.f) == out.size ();
+    }
+    if (!ok) {
+        Rcpp::stop ("Unable to write to temporary file [" + path + "]");
+    }
+}
+
+} // end anonymous namespace
+
+edge_sort::EdgeSource::EdgeSource (const std::string &path_in) :
+    path (path_in), buf (edge_sort::BUFFER_EDGES) {
+
+    f = std::fopen (path.c_str (), "rb");
+    if (f == nullptr) {
+        Rcpp::stop ("Unable to open sorted edge file [" + path + "]");
+    }
+    const uint64_t nbytes = scl_io::file_size (f, path);
+    if (nbytes % sizeof (edge_sort::Edge) != 0) {
+        Rcpp::stop ("Sorted edge file is truncated");
+    }
+    nedges = static_cast <size_t> (nbytes / sizeof (edge_sort::Edge));
+}
+
+void edge_sort::EdgeSource::rewind () {
+    pos = 0;
+    if (f != nullptr) {
+        std::rewind (f);
+    }
+}
+
+void edge_sort::EdgeSource::seek (const size_t p) {
+    pos = std::min (p, nedges);
+    if (f == nullptr || pos == nedges) {
+        return;
+    }
+    // Buffers are only filled on reading their first edge, so the buffer
+    // holding `p` is filled here unless `p` starts a new buffer.
+    const size_t start = pos - pos % edge_sort::BUFFER_EDGES;
+    scl_io::seek (f, static_cast <uint64_t> (start) *
+            sizeof (edge_sort::Edge), path);
+    if (pos > start) {
+        fill ();
+    }
+}
+
+void edge_sort::EdgeSource::fill () {
+    nbuf = std::fread (buf.data (), sizeof (edge_sort::Edge), buf.size (), f);
+    if (nbuf == 0) {
+        Rcpp::stop ("Sorted edge file is truncated");
+    }
+}
+
+std::string edge_sort::sort_edges (const Rcpp::NumericMatrix &xy,
+        const bool shortest,
+        const std::string &prefix,
+        const size_t max_edges,
+        TempFiles &tmp) {
+
+    const size_t n = static_cast <size_t> (xy.nrow ()),
+          p = static_cast <size_t> (xy.ncol ()),
+          ntot = n * n,
+          run_size = std::max (max_edges, static_cast <size_t> (1));
+    const double *x = xy.begin ();
+    const EdgeOrder order {n, shortest};
+
+    // Sorted runs of edges, with distances summed in the same order as
+    // `stats::dist`, so that values are identical.
+    std::vector <std::string> runs;
+    std::vector <edge_sort::Edge> run;
+    run.reserve (std::min (run_size, ntot));
+    size_t k = 0;
+    while (k < ntot) {
+        run.clear ();
+        const size_t kend = std::min (ntot, k + run_size);
+        for (; k < kend; k++) {
+            const size_t i = k % n, j = k / n;
+            double s = 0.0;
+            for (size_t c = 0; c < p; c++) {
+                const double dev = x [i + c * n] - x [j + c * n];
+                s += dev * dev;
+            }
+            edge_sort::Edge e;
+            e.from = static_cast <int> (i);
+            e.to = static_cast <int> (j);
+            e.d = std::sqrt (s);
+            run.push_back (e);
+        }
+        std::sort (run.begin (), run.end (), order);
+
+        const std::string path = prefix + "-" +
+            std::to_string (runs.size ()) + ".bin";
+        tmp.paths.push_back (path);
+        write_edges (path, run);
+        runs.push_back (path);
+
+        Rcpp::checkUserInterrupt ();
+    }
+    std::vector <edge_sort::Edge> ().swap (run);
+
+    // Merge passes, each of which reduces the number of runs by a factor of
+    // MAX_FANIN:
+    size_t pass = 0;
+    while (runs.size () > 1) {
+        std::vector <std::string> merged;
+        for (size_t g = 0; g < runs.size (); g += edge_sort::MAX_FANIN) {
+            const std::vector <std::string> group (runs.begin () +
+                    static_cast <long> (g), runs.begin () + static_cast <long> (
+                        std::min (g + edge_sort::MAX_FANIN, runs.size ())));
+            if (group.size () == 1) {
+                merged.push_back (group [0]);
+                continue;
+            }
+            const std::string path = prefix + "-m" + std::to_string (pass) +
+                "-" + std::to_string (merged.size ()) + ".bin";
+            tmp.paths.push_back (path);
+            merge_runs (group, path, order);
+            for (auto r: group) {
+                std::remove (r.c_str ());
+            }
+            merged.push_back (path);
+
+            Rcpp::checkUserInterrupt ();
+        }
+        runs = merged;
+        pass++;
+    }
+
+    return runs.empty () ? std::string () : runs [0];
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstdio>
+
+#include "utils.h"
+
+// --------- SORTED FULL-ORDER EDGE LISTS ----------------
+
+/* Full-order single and complete linkage both step through the list of all n^2
+ * edges between points, sorted by spatial distance. That list may be passed
+ * from R, or for large n generated here directly from the coordinates and
+ * sorted with an external merge sort, so that it never needs to be held in
+ * memory. Coordinates are divided into sorted "runs" of at most `max_edges`
+ * edges, each of which is written to a temporary file. Runs are then merged,
+ * at most MAX_FANIN at a time, into a single sorted file, which is read back
+ * with a small buffer.
+ *
+ * Edges are sorted by distance, with ties retaining their column-major order
+ * in the distance matrix, so that the order is identical to that of
+ * `dplyr::arrange` applied to the edges generated in R.
+ */
+
+namespace edge_sort {
+
+constexpr size_t MAX_FANIN = 64;
+constexpr size_t BUFFER_EDGES = 4096;
+
+// 0-indexed vertex numbers
+struct Edge {
+    int from, to;
+    double d;
+};
+
+static_assert (sizeof (Edge) == 16, "edge_sort::Edge must be 16 bytes");
+
+// Temporary files, all of which are removed on destruction, so that Rcpp::stop
+// may be called at any point.
+struct TempFiles {
+    std::vector <std::string> paths;
+
+    ~TempFiles () {
+        for (auto p: paths) {
+            std::remove (p.c_str ());
+        }
+    }
+};
+
+// Sequential, seekable source of sorted edges, either from (from, to, d)
+// views of vectors in memory, or from a file written by `sort_edges`. `d` may
+// be `nullptr` where distances are not needed.
+class EdgeSource {
+    const utils::IndexView *from = nullptr, *to = nullptr;
+    const double *d = nullptr;
+    const policy::rank_t *ranks = nullptr;
+
+    FILE *f = nullptr;
+    std::string path;
+    std::vector <Edge> buf;
+    size_t nbuf = 0;
+
+    size_t pos = 0, nedges = 0;
+
+public:
+    EdgeSource (const utils::IndexView &from_in,
+            const utils::IndexView &to_in, const double *d_in = nullptr) :
+        from (&from_in), to (&to_in), d (d_in),
+        nedges (static_cast <size_t> (from_in.size ())) {}
+
+    // Equivalent for distances replaced by their ranks
+    EdgeSource (const utils::IndexView &from_in,
+            const utils::IndexView &to_in, const policy::rank_t *ranks_in) :
+        from (&from_in), to (&to_in), ranks (ranks_in),
+        nedges (static_cast <size_t> (from_in.size ())) {}
+
+    explicit EdgeSource (const std::string &path_in);
+
+    ~EdgeSource () {
+        if (f != nullptr) {
+            std::fclose (f);
+        }
+    }
+
+    EdgeSource (const EdgeSource &) = delete;
+    EdgeSource &operator= (const EdgeSource &) = delete;
+
+    size_t size () const {
+        return nedges;
+    }
+
+    // Position of the next edge to be read
+    size_t position () const {
+        return pos;
+    }
+
+    void rewind ();
+
+    // Move to position `p`, which for files seeks directly to the buffer
+    // holding `p`.
+    void seek (const size_t p);
+
+    bool next (Edge &e) {
+        if (pos >= nedges) {
+            return false;
+        }
+        if (f == nullptr) {
+            e.from = (*from) [pos];
+            e.to = (*to) [pos];
+            if (d != nullptr) {
+                e.d = d [pos];
+            } else {
+                e.d = ranks == nullptr ? 0.0 : ranks [pos];
+            }
+        } else {
+            const size_t i = pos % BUFFER_EDGES;
+            if (i == 0) {
+                fill ();
+            }
+            e = buf [i];
+        }
+        pos++;
+        return true;
+    }
+
+private:
+    void fill ();
+};
+
+// Write all (n x n) edges between the rows of `xy`, sorted by Euclidean
+// distance, to a single file, and return its path. All files are created with
+// names starting with `prefix`, and registered with `tmp` for removal.
+std::string sort_edges (const Rcpp::NumericMatrix &xy,
+        const bool shortest,
+        const std::string &prefix,
+        const size_t max_edges,
+        TempFiles &tmp);
+
+} // end namespace edge_sort
@@ -0,0 +1,416 @@
+#include "common.h"
+#include "full-cut.h"
+
+full_cut::Dendrogram::Dendrogram (const Rcpp::IntegerVector &from,
+        const Rcpp::IntegerVector &to,
+        const Rcpp::IntegerVector &cluster,
+        const Rcpp::IntegerVector &m_from,
+        const Rcpp::IntegerVector &m_to,
+        const size_t min_nodes_in) :
+    merge_from (m_from.begin (), m_from.end ()),
+    merge_to (m_to.begin (), m_to.end ()),
+    min_nodes (min_nodes_in) {
+
+    const R_xlen_t m = from.size ();
+
+    // Initial clusters of each node, with edges in no cluster (NA or < 0)
+    // contributing none.
+    bool any_na = false;
+    std::unordered_map <int, std::vector <size_t> > node_cl;
+    std::vector <int> node_order; // order of first appearance in c(from, to)
+    for (int pass = 0; pass < 2; pass++) {
+        const Rcpp::IntegerVector &v = pass == 0 ? from : to;
+        for (R_xlen_t i = 0; i < m; i++) {
+            auto it = node_cl.find (v [i]);
+            if (it == node_cl.end ()) {
+                it = node_cl.emplace (v [i], std::vector <size_t> ()).first;
+                node_order.push_back (v [i]);
+            }
+            const int cl = cluster [i];
+            if (cl == NA_INTEGER || cl < 0) {
+                any_na = true;
+                continue;
+            }
+            auto li = label_index.find (cl);
+            if (li == label_index.end ()) {
+                li = label_index.emplace (cl, labels.size ()).first;
+                labels.push_back (cl);
+            }
+            it->second.push_back (li->second);
+        }
+    }
+    num_labels = labels.size () + (any_na ? 1 : 0);
+
+    // Nodes in any cluster in order of node number, followed by nodes in no
+    // cluster in order of appearance.
+    std::vector <int> in_cl, no_cl;
+    for (auto n: node_order) {
+        if (node_cl.at (n).empty ()) {
+            no_cl.push_back (n);
+        } else {
+            in_cl.push_back (n);
+        }
+    }
+    std::sort (in_cl.begin (), in_cl.end ());
+    nodes = in_cl;
+    nodes.insert (nodes.end (), no_cl.begin (), no_cl.end ());
+
+    node_clusters.reserve (nodes.size ());
+    for (auto n: nodes) {
+        std::vector <size_t> &cls = node_cl.at (n);
+        std::sort (cls.begin (), cls.end ());
+        cls.erase (std::unique (cls.begin (), cls.end ()), cls.end ());
+        node_clusters.push_back (cls);
+    }
+
+    replay ();
+    count_clusters ();
+}
+
+// Number of merges after which sets `a` and `b` are first joined, or NONE.
+// Links are made in increasing order of step up the union-find tree, so this
+// is the step of the last link on the path from either to their common
+// ancestor.
+size_t full_cut::Dendrogram::join_step (size_t a, size_t b) const {
+
+    auto depth = [this] (size_t i) {
+        size_t d = 0;
+        while (parent [i] != i) {
+            i = parent [i];
+            d++;
+        }
+        return d;
+    };
+    size_t da = depth (a), db = depth (b), step = 0;
+    while (da > db) {
+        step = std::max (step, link_step [a]);
+        a = parent [a];
+        da--;
+    }
+    while (db > da) {
+        step = std::max (step, link_step [b]);
+        b = parent [b];
+        db--;
+    }
+    while (a != b) {
+        if (parent [a] == a) {
+            return full_cut::NONE;
+        }
+        step = std::max (step, std::max (link_step [a], link_step [b]));
+        a = parent [a];
+        b = parent [b];
+    }
+
+    return step;
+}
+
+void full_cut::Dendrogram::replay () {
+
+    const size_t nl = labels.size ();
+    parent.resize (nl);
+    size.assign (nl, 1);
+    link_step.assign (nl, full_cut::NONE);
+    for (size_t i = 0; i < nl; i++) {
+        parent [i] = i;
+    }
+
+    std::unordered_map <int, size_t> label_set = label_index;
+    step_set.assign (merge_from.size () + 1, full_cut::NONE);
+    for (size_t s = 1; s <= merge_from.size (); s++) {
+        const int f = merge_from [s - 1], t = merge_to [s - 1];
+        const auto itf = label_set.find (f);
+        if (f == t || itf == label_set.end ()) {
+            continue;
+        }
+        size_t a = itf->second;
+        label_set.erase (itf);
+        const auto itt = label_set.find (t);
+        if (itt == label_set.end ()) { // relabel only
+            label_set.emplace (t, a);
+            step_set [s] = a;
+            continue;
+        }
+        size_t b = itt->second;
+        if (size [a] < size [b]) {
+            std::swap (a, b);
+        }
+        parent [b] = a;
+        size [a] += size [b];
+        link_step [b] = s;
+        itt->second = a;
+        step_set [s] = a;
+    }
+
+    node_step.resize (nodes.size ());
+    for (size_t i = 0; i < nodes.size (); i++) {
+        const std::vector <size_t> &cls = node_clusters [i];
+        if (cls.empty ()) {
+            node_step [i] = full_cut::NONE;
+            continue;
+        }
+        size_t step = 0;
+        for (size_t j = 1; j < cls.size () && step != full_cut::NONE; j++) {
+            step = std::max (step, join_step (cls [0], cls [j]));
+        }
+        node_step [i] = step;
+    }
+}
+
+void full_cut::Dendrogram::count_clusters () {
+
+    const size_t nm = merge_from.size ();
+    std::vector <std::vector <size_t> > step_nodes (nm + 1);
+    for (size_t i = 0; i < nodes.size (); i++) {
+        if (node_step [i] != full_cut::NONE) {
+            step_nodes [node_step [i]].push_back (i);
+        }
+    }
+    // The links made at each step
+    std::vector <size_t> step_link (nm + 1, full_cut::NONE);
+    for (size_t i = 0; i < parent.size (); i++) {
+        if (parent [i] != i) {
+            step_link [link_step [i]] = i;
+        }
+    }
+
+    auto big = [this] (const size_t n) {
+        return n >= min_nodes ? 1 : 0;
+    };
+
+    std::vector <size_t> count (labels.size (), 0);
+    num_big.resize (nm + 1);
+    size_t nbig = 0;
+    for (size_t s = 0; s <= nm; s++) {
+        if (step_link [s] != full_cut::NONE) {
+            const size_t b = step_link [s], a = parent [b];
+            nbig -= big (count [a]) + big (count [b]);
+            count [a] += count [b];
+            nbig += big (count [a]);
+        }
+        for (auto i: step_nodes [s]) {
+            // Root at step s, which is the current root of the union-find
+            // restricted to links made up to that step
+            size_t r = node_clusters [i] [0];
+            while (parent [r] != r && link_step [r] <= s) {
+                r = parent [r];
+            }
+            nbig -= big (count [r]);
+            count [r]++;
+            nbig += big (count [r]);
+        }
+        num_big [s] = nbig;
+    }
+}
+
+size_t full_cut::Dendrogram::num_merges (const int ncl) const {
+    const long m = static_cast <long> (num_labels) - ncl - 1;
+    if (m < 0) {
+        return 0;
+    }
+    return std::min (static_cast <size_t> (m), merge_from.size ());
+}
+
+size_t full_cut::Dendrogram::num_merges_min_size (const int ncl) const {
+
+    const int nn = static_cast <int> (nodes.size ());
+    int ncl_trial = ncl;
+    size_t m = num_merges (ncl_trial);
+    while (static_cast <int> (num_big [m]) < ncl) {
+        ncl_trial++;
+        if (ncl_trial >= nn) {
+            break;
+        }
+        m = num_merges (ncl_trial);
+    }
+
+    return m;
+}
+
+std::vector <int> full_cut::Dendrogram::cut (const size_t m) const {
+
+    // Labels of each set after m merges
+    std::vector <int> set_label = labels;
+    for (size_t s = 1; s <= m; s++) {
+        if (step_set [s] != full_cut::NONE) {
+            set_label [step_set [s]] = merge_to [s - 1];
+        }
+    }
+
+    std::vector <int> res (nodes.size (), NA_INTEGER);
+    std::unordered_map <int, size_t> counts;
+    for (size_t i = 0; i < nodes.size (); i++) {
+        if (node_step [i] == full_cut::NONE || node_step [i] > m) {
+            continue;
+        }
+        size_t r = node_clusters [i] [0];
+        while (parent [r] != r && link_step [r] <= m) {
+            r = parent [r];
+        }
+        res [i] = set_label [r];
+        counts [res [i]]++;
+    }
+    for (auto &r: res) {
+        if (r != NA_INTEGER && counts.at (r) < min_nodes) {
+            r = NA_INTEGER;
+        }
+    }
+
+    return res;
+}
+
+full_cut::Hclust full_cut::hclust (const Rcpp::IntegerVector &from,
+        const Rcpp::IntegerVector &to, const Rcpp::NumericVector &dist) {
+
+    full_cut::Hclust res;
+    const size_t nm = static_cast <size_t> (from.size ());
+    if (nm == 0) {
+        return res;
+    }
+
+    // Ranks of cluster numbers
+    int max_id = 0;
+    for (size_t i = 0; i < nm; i++) {
+        // NA_INTEGER is also negative
+        if (from [i] < 0 || to [i] < 0) {
+            Rcpp::stop ("Merges must be between non-negative cluster numbers");
+        }
+        max_id = std::max (max_id, std::max (from [i], to [i]));
+    }
+    std::vector <int> rank (static_cast <size_t> (max_id) + 1, -1);
+    for (size_t i = 0; i < nm; i++) {
+        rank [static_cast <size_t> (from [i])] = 0;
+        rank [static_cast <size_t> (to [i])] = 0;
+    }
+    int nl = 0;
+    for (auto &r: rank) {
+        if (r == 0) {
+            r = nl++;
+        }
+    }
+    auto rank_of = [&rank] (const int id) {
+        return static_cast <size_t> (rank [static_cast <size_t> (id)]);
+    };
+
+    // Last merge of each cluster, as a 1-indexed row number, or 0
+    std::vector <int> last (static_cast <size_t> (nl), 0);
+    res.merge.resize (2 * nm);
+    res.height.resize (nm);
+    for (size_t i = 0; i < nm; i++) {
+        res.height [i] = dist [static_cast <R_xlen_t> (i)];
+        for (size_t j = 0; j < 2; j++) {
+            const size_t k = rank_of (j == 0 ? from [i] : to [i]);
+            if (last [k] == 0) {
+                res.merge [i + j * nm] = -static_cast <int> (k + 1);
+            } else {
+                res.merge [i + j * nm] = last [k];
+                res.height [i] +=
+                    res.height [static_cast <size_t> (last [k] - 1)];
+            }
+            last [k] = static_cast <int> (i + 1);
+        }
+    }
+
+    // Leaf order
+    std::vector <size_t> next (static_cast <size_t> (nl), full_cut::NONE),
+        prev (static_cast <size_t> (nl), full_cut::NONE);
+    size_t head = rank_of (from [nm - 1]);
+    next [head] = rank_of (to [nm - 1]);
+    prev [next [head]] = head;
+    for (size_t i = nm - 1; i-- > 0; ) {
+        const size_t f = rank_of (from [i]), t = rank_of (to [i]);
+        const size_t p = prev [t];
+        prev [f] = p;
+        next [f] = t;
+        prev [t] = f;
+        if (p == full_cut::NONE) {
+            head = f;
+        } else {
+            next [p] = f;
+        }
+    }
+
+    std::vector <int> ids (static_cast <size_t> (nl));
+    for (size_t i = 0; i < rank.size (); i++) {
+        if (rank [i] >= 0) {
+            ids [static_cast <size_t> (rank [i])] = static_cast <int> (i);
+        }
+    }
+    for (size_t k = head; k != full_cut::NONE; k = next [k]) {
+        res.order.push_back (static_cast <int> (k + 1));
+        res.ord.push_back (ids [k]);
+    }
+
+    return res;
+}
+
+//' rcpp_full_cut
+//'
+//' Cut the hierarchy of merges from rcpp_full_merge to give at least `ncl`
+//' clusters of at least `min_size` nodes.
+//'
+//' @param edges Edges with columns of (from, to, cluster), where `cluster` is
+//' the initial cluster number, and NA or negative for edges between clusters.
+//' @param merges Merges with columns of (from, to) from rcpp_full_merge.
+//' @param ncl Desired number of clusters
+//' @param min_size Minimal number of nodes in each cluster
+//'
+//' @return `data.frame` of (node, cluster), with NA for nodes in no cluster.
+//' @noRd
+// [[Rcpp::export]]
+Rcpp::DataFrame rcpp_full_cut (
+        const Rcpp::DataFrame edges,
+        const Rcpp::DataFrame merges,
+        const int ncl,
+        const int min_size) {
+
+    const Rcpp::IntegerVector from = edges ["from"];
+    const Rcpp::IntegerVector to = edges ["to"];
+    const Rcpp::IntegerVector cluster = edges ["cluster"];
+    const Rcpp::IntegerVector m_from = merges ["from"];
+    const Rcpp::IntegerVector m_to = merges ["to"];
+
+    if (min_size < 1) {
+        Rcpp::stop ("min_size must be positive");
+    }
+
+    const full_cut::Dendrogram dendro (from, to, cluster, m_from, m_to,
+            static_cast <size_t> (min_size));
+    const std::vector <int> cl = dendro.cut (dendro.num_merges_min_size (ncl));
+
+    return Rcpp::DataFrame::create (
+        Rcpp::Named ("node") = dendro.node_ids (),
+        Rcpp::Named ("cluster") = cl,
+        Rcpp::_["stringsAsFactors"] = false);
+}
+
+//' rcpp_merges_hclust
+//'
+//' Convert merges from rcpp_full_merge to the components of an `hclust`
+//' object.
+//'
+//' @param merges Merges with columns of (from, to, dist) from rcpp_full_merge.
+//'
+//' @return List of `merge`, `height`, and `order`, as for `hclust` objects,
+//' with clusters indexed by the ranks of their original numbers, and `ord`, the
+//' original, 0-indexed cluster numbers in the same order as `order`.
+//' @noRd
+// [[Rcpp::export]]
+Rcpp::List rcpp_merges_hclust (const Rcpp::DataFrame merges) {
+
+    const Rcpp::IntegerVector from = merges ["from"];
+    const Rcpp::IntegerVector to = merges ["to"];
+    const Rcpp::NumericVector dist = merges ["dist"];
+
+    const full_cut::Hclust hc = full_cut::hclust (from, to, dist);
+
+    const int nm = static_cast <int> (from.size ());
+    Rcpp::IntegerMatrix merge (nm, 2);
+    std::copy (hc.merge.begin (), hc.merge.end (), merge.begin ());
+
+    return Rcpp::List::create (
+        Rcpp::Named ("merge") = merge,
+        Rcpp::Named ("height") = hc.height,
+        Rcpp::Named ("order") = hc.order,
+        Rcpp::Named ("ord") = Rcpp::NumericVector (hc.ord.begin (),
+            hc.ord.end ()));
+}
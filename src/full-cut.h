@@ -0,0 +1,102 @@
+#pragma once
+
+// --------- CUT FULL CLUSTER HIERARCHIES ----------------
+
+/* The merges of initial clusters returned by rcpp_full_merge form a
+ * dendrogram, which is cut here to assign nodes to clusters. Each merge
+ * relabels all clusters of the "from" label with the "to" label, and nodes
+ * belong to a cluster only once all clusters of their edges share one label.
+ *
+ * Merges are replayed once with a union-find, which links the sets of each
+ * merge without path compression, and records the step at which each link was
+ * made. The step at which any two initial clusters join is then the latest
+ * link on the paths from each to their common ancestor, from which the step at
+ * which each node is first assigned follows directly. A single further pass
+ * over the merges then gives the number of clusters of at least `min_nodes`
+ * nodes after any number of merges, so that the number of
+ * merges needed for any requested number of clusters is found without
+ * repeatedly re-cutting the tree.
+ */
+
+namespace full_cut {
+
+constexpr size_t NONE = std::numeric_limits <size_t>::max ();
+
+class Dendrogram {
+    std::vector <int> merge_from, merge_to;
+
+    // Clusters of fewer nodes than this are treated as unclustered
+    size_t min_nodes;
+
+    // Initial cluster labels, and union-find parents, sizes, and the steps at
+    // which each set was linked to its parent
+    std::vector <int> labels;
+    std::vector <size_t> parent, size, link_step;
+    std::unordered_map <int, size_t> label_index;
+    // Set labelled by the "to" label of each merge, or NONE if no set was
+    std::vector <size_t> step_set;
+
+    // Nodes in order of output, with the initial clusters of each, and the
+    // number of merges after which each is first assigned to a cluster.
+    std::vector <int> nodes;
+    std::vector <std::vector <size_t> > node_clusters;
+    std::vector <size_t> node_step;
+
+    // Numbers of clusters of >= min_nodes after each number of merges
+    std::vector <size_t> num_big;
+
+    size_t num_labels; // including NA where any edges are in no cluster
+
+    size_t join_step (size_t a, size_t b) const;
+    void replay ();
+    void count_clusters ();
+
+public:
+    Dendrogram (const Rcpp::IntegerVector &from,
+            const Rcpp::IntegerVector &to,
+            const Rcpp::IntegerVector &cluster,
+            const Rcpp::IntegerVector &m_from,
+            const Rcpp::IntegerVector &m_to,
+            const size_t min_nodes_in);
+
+    // Number of merges which leaves `ncl` clusters
+    size_t num_merges (const int ncl) const;
+
+    // Numbers of merges for the smallest number of clusters >= `ncl` which
+    // gives at least `ncl` clusters of >= min_nodes nodes
+    size_t num_merges_min_size (const int ncl) const;
+
+    // Cluster labels of all nodes after `m` merges, or NA_INTEGER for nodes in
+    // no cluster, including those in clusters of < min_nodes.
+    std::vector <int> cut (const size_t m) const;
+
+    const std::vector <int> &node_ids () const { return nodes; }
+};
+
+// A merge hierarchy in the form of `stats::hclust`, with clusters indexed by
+// their ranks among all cluster numbers. `merge` is (nmerges x 2) and
+// column-major, with negative values for single clusters, and positive values
+// for the 1-indexed rows of earlier merges. Heights are cumulative distances
+// of all merges within each branch, and `order` is the 1-indexed order of
+// clusters as leaves of the dendrogram, with `ord` the equivalent original,
+// 0-indexed cluster numbers.
+struct Hclust {
+    std::vector <int> merge, order, ord;
+    std::vector <double> height;
+};
+
+// Both conversion and ordering take a single pass over the merges, with leaves
+// ordered by inserting the "from" cluster of each merge, in reverse order,
+// before the "to" cluster in a linked list.
+Hclust hclust (const Rcpp::IntegerVector &from, const Rcpp::IntegerVector &to,
+        const Rcpp::NumericVector &dist);
+
+} // end namespace full_cut
+
+Rcpp::DataFrame rcpp_full_cut (
+        const Rcpp::DataFrame edges,
+        const Rcpp::DataFrame merges,
+        const int ncl,
+        const int min_size);
+
+Rcpp::List rcpp_merges_hclust (const Rcpp::DataFrame merges);
@@ -1,13 +1,15 @@
 #include "common.h"
 #include "utils.h"
+#include "policies.h"
 #include "full-init.h"
 
 // --------- FULL CLUSTER ----------------
 
-void full_init::init (full_init::FullInitDat &clfull_dat,
-        Rcpp::IntegerVector from,
-        Rcpp::IntegerVector to,
-        Rcpp::NumericVector d) {
+template <typename T>
+void full_init::init (full_init::FullInitDat <T> &clfull_dat,
+        const utils::IndexView &from,
+        const utils::IndexView &to,
+        const Rcpp::NumericVector &d) {
     intset_t vert_set;
     for (int i = 0; i < from.size (); i++) {
         vert_set.emplace (from [i]);
@@ -25,10 +27,10 @@ void full_init::init (full_init::FullInitDat &clfull_dat,
     clfull_dat.edges.clear ();
     clfull_dat.edges.resize (static_cast <size_t> (from.size ()));
     for (int i = 0; i < from.size (); i++) {
-        utils::OneEdge here;
+        utils::OneEdge <T> here;
         here.from = from [i];
         here.to = to [i];
-        here.dist = d [i];
+        here.dist = static_cast <T> (d [i]);
         clfull_dat.edges [static_cast <size_t> (i)] = here;
     }
 
@@ -38,10 +40,11 @@ void full_init::init (full_init::FullInitDat &clfull_dat,
 }
 
 
-void full_init::assign_first_edge (full_init::FullInitDat &clfull_dat) {
+template <typename T>
+void full_init::assign_first_edge (full_init::FullInitDat <T> &clfull_dat) {
     int clnum = 0;
     index_t ei = 0;
-    utils::OneEdge edge = clfull_dat.edges [ei];
+    utils::OneEdge <T> edge = clfull_dat.edges [ei];
     index_t ito = clfull_dat.vert2index_map.at (edge.to),
             ifrom = clfull_dat.vert2index_map.at (edge.from);
 
@@ -67,10 +70,11 @@ void full_init::assign_first_edge (full_init::FullInitDat &clfull_dat) {
 //'
 //' @param ei The i'th edge of the sorted list of NN edge weights
 //' @noRd
-int full_init::step (full_init::FullInitDat &clfull_dat,
+template <typename T>
+int full_init::step (full_init::FullInitDat <T> &clfull_dat,
         const index_t ei, const int clnum) {
     bool from_in = false, to_in = false;
-    utils::OneEdge edge = clfull_dat.edges [ei];
+    utils::OneEdge <T> edge = clfull_dat.edges [ei];
     index_t ito = clfull_dat.vert2index_map.at (edge.to),
             ifrom = clfull_dat.vert2index_map.at (edge.from);
     if (clfull_dat.index_in_cluster [ito]) {
@@ -118,8 +122,9 @@ int full_init::step (full_init::FullInitDat &clfull_dat,
 //' Fill (arma) matrix of strongest/shortest connections between all clusters
 //' used to construct the hierarchical relationships
 //' @noRd
-void full_init::fill_cl_edges (full_init::FullInitDat &clfull_dat,
-        arma::Mat <double> &cl_edges, int num_clusters) {
+template <typename T, typename Cmp>
+void full_init::fill_cl_edges (full_init::FullInitDat <T> &clfull_dat,
+        arma::Mat <T> &cl_edges, int num_clusters) {
     int2intset_map_t vert_sets;
     for (int i = 0; i < num_clusters; i++) {
         intset_t verts;
@@ -133,9 +138,9 @@ void full_init::fill_cl_edges (full_init::FullInitDat &clfull_dat,
 
     // need a (sparse) matrix of all pairwise edge distances:
     arma::uword nu = static_cast <arma::uword> (clfull_dat.n);
-    arma::Mat <double> vert_dists (nu, nu);
-    if (!clfull_dat.shortest) {
-        vert_dists.fill (INFINITE_DOUBLE);
+    arma::Mat <T> vert_dists (nu, nu);
+    if (!Cmp::shortest) {
+        vert_dists.fill (infinite_value <T> ());
     }
     for (auto ei: clfull_dat.edges) {
         arma::uword i = static_cast <arma::uword> (
@@ -150,9 +155,9 @@ void full_init::fill_cl_edges (full_init::FullInitDat &clfull_dat,
         {
             intset_t verts_i = vert_sets.at (i),
                      verts_j = vert_sets.at (j);
-            double max_d = 0.0;
-            if (!clfull_dat.shortest) {
-                max_d = INFINITE_DOUBLE; // min covariance
+            T max_d = 0.0;
+            if (!Cmp::shortest) {
+                max_d = infinite_value <T> (); // min covariance
             }
             for (auto vi: verts_i) {
                 for (auto vj: verts_j)
@@ -161,10 +166,7 @@ void full_init::fill_cl_edges (full_init::FullInitDat &clfull_dat,
                             clfull_dat.vert2index_map.at (vi)),
                                 vju = static_cast <arma::uword> (
                             clfull_dat.vert2index_map.at (vj));
-                    if ((clfull_dat.shortest &&
-                                vert_dists (viu, vju) > max_d) ||
-                        (!clfull_dat.shortest &&
-                                vert_dists (viu, vju) < max_d)) {
+                    if (Cmp::better (max_d, vert_dists (viu, vju))) {
                         max_d = vert_dists (viu, vju);
                     }
                 }
@@ -177,28 +179,12 @@ void full_init::fill_cl_edges (full_init::FullInitDat &clfull_dat,
 }
 
 
-//' rcpp_full_initial
-//'
-//' Initial allocation for full clustering
-//'
-//' @noRd
-// [[Rcpp::export]]
-Rcpp::IntegerVector rcpp_full_initial (
-        const Rcpp::DataFrame gr,
-        bool shortest) {
-    Rcpp::IntegerVector from_ref = gr ["from"];
-    Rcpp::IntegerVector to_ref = gr ["to"];
-    Rcpp::NumericVector d_ref = gr ["d"];
-    Rcpp::IntegerVector from = Rcpp::clone (from_ref);
-    Rcpp::IntegerVector to = Rcpp::clone (to_ref);
-    Rcpp::NumericVector d = Rcpp::clone (d_ref);
-
-    // Index vectors are 1-indexed, so
-    from = from - 1;
-    to = to - 1;
-
-    full_init::FullInitDat clfull_dat;
-    clfull_dat.shortest = shortest;
+template <typename T, typename Cmp>
+std::vector <int> full_init::full_initial (
+        const utils::IndexView &from,
+        const utils::IndexView &to,
+        const Rcpp::NumericVector &d) {
+    full_init::FullInitDat <T> clfull_dat;
     full_init::init (clfull_dat, from, to, d);
 
     full_init::assign_first_edge (clfull_dat);
@@ -215,14 +201,37 @@ Rcpp::IntegerVector rcpp_full_initial (
 
     // Then construct the hierarchical relationships among clusters
     arma::uword cu = static_cast <arma::uword> (clnum);
-    arma::Mat <double> cl_edges (cu, cu);
-    full_init::fill_cl_edges (clfull_dat, cl_edges, clnum);
+    arma::Mat <T> cl_edges (cu, cu);
+    full_init::fill_cl_edges <T, Cmp> (clfull_dat, cl_edges, clnum);
 
     // Then construct vector mapping edges to cluster numbers
     std::vector <int> clvec (clfull_dat.n);
     for (auto ci: clfull_dat.vert2cl_map) {
         clvec [static_cast <size_t> (ci.first)] = ci.second;
     }
-    
+
+    return clvec;
+}
+
+//' rcpp_full_initial
+//'
+//' Initial allocation for full clustering
+//'
+//' @noRd
+// [[Rcpp::export]]
+Rcpp::IntegerVector rcpp_full_initial (
+        const Rcpp::DataFrame gr,
+        bool shortest,
+        const std::string precision) {
+    // Views convert R's 1-indexed vertex numbers without copying
+    Rcpp::IntegerVector from_ref = gr ["from"];
+    Rcpp::IntegerVector to_ref = gr ["to"];
+    Rcpp::NumericVector d = gr ["d"];
+
+    const utils::IndexView from (from_ref), to (to_ref);
+
+    std::vector <int> clvec = policy::dispatch <full_init::FullInitial> (
+            precision, shortest, from, to, d);
+
     return Rcpp::wrap (clvec);
 }
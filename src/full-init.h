@@ -11,11 +11,12 @@
 
 namespace full_init {
 
+// Templated on the distance type, T, which is either float or double.
+template <typename T>
 struct FullInitDat {
-    bool shortest;
     size_t n;
 
-    std::vector <utils::OneEdge> edges; // nearest neighbour edges only
+    std::vector <utils::OneEdge <T> > edges; // nearest neighbour edges only
     std::vector <bool> index_in_cluster;
 
     int2int_map_t vert2cl_map;
@@ -24,21 +25,42 @@ struct FullInitDat {
     int2intset_map_t cl2index_map;
 };
 
-void init (FullInitDat &clfull_dat,
-        Rcpp::IntegerVector from,
-        Rcpp::IntegerVector to,
-        Rcpp::NumericVector d);
+template <typename T>
+void init (FullInitDat <T> &clfull_dat,
+        const utils::IndexView &from,
+        const utils::IndexView &to,
+        const Rcpp::NumericVector &d);
 
-void assign_first_edge (FullInitDat &clfull_dat);
+template <typename T>
+void assign_first_edge (FullInitDat <T> &clfull_dat);
 
-int step (FullInitDat &clfull_dat, const index_t ei,
+template <typename T>
+int step (FullInitDat <T> &clfull_dat, const index_t ei,
         const int clnum);
 
-void fill_cl_edges (FullInitDat &clfull_dat, arma::Mat <double> &cl_edges,
+// Cmp is the comparison policy, either policy::Shortest or policy::Longest
+template <typename T, typename Cmp>
+void fill_cl_edges (FullInitDat <T> &clfull_dat, arma::Mat <T> &cl_edges,
         int num_clusters);
 
+template <typename T, typename Cmp>
+std::vector <int> full_initial (
+        const utils::IndexView &from,
+        const utils::IndexView &to,
+        const Rcpp::NumericVector &d);
+
+// Target for policy::dispatch
+struct FullInitial {
+    template <typename T, typename Cmp>
+    static std::vector <int> run (const utils::IndexView &from,
+            const utils::IndexView &to, Rcpp::NumericVector d) {
+        return full_initial <T, Cmp> (from, to, d);
+    }
+};
+
 } // end namespace ex_init
 
 Rcpp::IntegerVector rcpp_full_initial (
         const Rcpp::DataFrame gr,
-        bool shortest);
+        bool shortest,
+        const std::string precision);
@@ -1,10 +1,13 @@
 #include "common.h"
 #include "full-merge.h"
+#include "policies.h"
+#include "radix-sort.h"
 
 // load data from rcpp_full_initial into the FullMergeDat struct. The gr data
 // are pre-sorted by increasing d.
+template <typename T, typename Cmp>
 void full_merge::init (const Rcpp::DataFrame &gr,
-        full_merge::FullMergeDat &cldat)
+        full_merge::FullMergeDat <T> &cldat)
 {
     Rcpp::IntegerVector from = gr ["from"];
     Rcpp::IntegerVector to = gr ["to"];
@@ -16,16 +19,16 @@ void full_merge::init (const Rcpp::DataFrame &gr,
     const size_t n = static_cast <size_t> (d.size ());
     
     cldat.edges.resize (n);
-    std::unordered_map <int, std::unordered_set <double> > cl2dist_map;
-    std::unordered_map <std::string, double> edge_dist_map;
+    std::unordered_map <int, std::unordered_set <T> > cl2dist_map;
+    std::unordered_map <std::string, T> edge_dist_map;
     for (int i = 0; i < static_cast <int> (n); i++) {
         if (clnum [i] >= 0) { // edge in a cluster
             int clnum_i = clnum [i];
 
-            std::unordered_set <double> distset;
+            std::unordered_set <T> distset;
             if (cl2dist_map.find (clnum_i) != cl2dist_map.end ())
                 distset = cl2dist_map.at (clnum_i);
-            distset.emplace (d [i]);
+            distset.emplace (static_cast <T> (d [i]));
 
             cl2dist_map [clnum_i] = distset;
         } else {
@@ -37,7 +40,7 @@ void full_merge::init (const Rcpp::DataFrame &gr,
                               std::to_string (clfrom [i]);
             if (edge_dist_map.find (eft) == edge_dist_map.end () &&
                     edge_dist_map.find (etf) == edge_dist_map.end ())
-                edge_dist_map.emplace (eft, d [i]);
+                edge_dist_map.emplace (eft, static_cast <T> (d [i]));
         }
     }
 
@@ -46,11 +49,11 @@ void full_merge::init (const Rcpp::DataFrame &gr,
     size_t edge_count = 0;
     for (int i = 0; i < static_cast <int> (n); i++) {
         if (clnum [i] < 0) { // edge not in a cluster
-            utils::OneEdge edgei;
+            utils::OneEdge <T> edgei;
             // clfrom and clto hold cluster numbers, NOT vertex numbers
             edgei.from = clfrom [i];
             edgei.to = clto [i];
-            edgei.dist = d [i];
+            edgei.dist = static_cast <T> (d [i]);
 
             std::string eft = std::to_string (edgei.from) + "-" +
                               std::to_string (edgei.to),
@@ -59,18 +62,16 @@ void full_merge::init (const Rcpp::DataFrame &gr,
             if (edge_dist_map.find (eft) == edge_dist_map.end () &&
                     edge_dist_map.find (etf) == edge_dist_map.end ())
             {
-                edge_dist_map.emplace (eft, d [i]);
+                edge_dist_map.emplace (eft, edgei.dist);
                 cldat.edges [edge_count++] = edgei;
             } else if (edge_dist_map.find (etf) != edge_dist_map.end ())
             {
-                if ((cldat.shortest && d [i] < edge_dist_map.at (etf)) ||
-                        (!cldat.shortest && d [i] > edge_dist_map.at (etf)))
-                    edge_dist_map [etf] = d [i];
+                if (Cmp::better (edgei.dist, edge_dist_map.at (etf)))
+                    edge_dist_map [etf] = edgei.dist;
             } else
             {
-                if ((cldat.shortest && d [i] < edge_dist_map.at (eft)) ||
-                        (!cldat.shortest && d [i] > edge_dist_map.at (eft)))
-                    edge_dist_map [eft] = d [i];
+                if (Cmp::better (edgei.dist, edge_dist_map.at (eft)))
+                    edge_dist_map [eft] = edgei.dist;
             }
         }
     }
@@ -78,25 +79,23 @@ void full_merge::init (const Rcpp::DataFrame &gr,
     for (auto ei: cldat.edges) {
         std::string eft = std::to_string (ei.from) + "-" +
                           std::to_string (ei.to);
-        if ((cldat.shortest && edge_dist_map.at (eft) < ei.dist) ||
-                (!cldat.shortest && edge_dist_map.at (eft) > ei.dist))
+        if (Cmp::better (edge_dist_map.at (eft), ei.dist))
             ei.dist = edge_dist_map.at (eft);
     }
 
     // Fill intra-cluster data:
     for (auto i: cl2dist_map) {
-        std::unordered_set <double> distset = i.second;
-        OneCluster cli;
+        std::unordered_set <T> distset = i.second;
+        OneCluster <T> cli;
         cli.id = i.first;
         cli.n = distset.size ();
         cli.dist_sum = 0.0;
         cli.dist_max = 0.0;
-        if (!cldat.shortest)
-            cli.dist_max = INFINITE_DOUBLE;
+        if (!Cmp::shortest)
+            cli.dist_max = infinite_value <T> ();
         for (auto di: distset) {
             cli.dist_sum += di;
-            if ((cldat.shortest && di > cli.dist_max) ||
-                    (!cldat.shortest && di < cli.dist_max))
+            if (Cmp::better (cli.dist_max, di))
                 cli.dist_max = di;
         }
         cldat.clusters.emplace (i.first, cli);
@@ -110,22 +109,22 @@ void full_merge::init (const Rcpp::DataFrame &gr,
 
 // merge cluster clfrom with clto; clfrom remains as it was but is no longer
 // indexed so simply ignored from that point on
-full_merge::OneMerge full_merge::merge_one_single (full_merge::FullMergeDat &cldat,
-        index_t ei) {
+template <typename T, typename Cmp>
+full_merge::OneMerge full_merge::merge_one_single (
+        full_merge::FullMergeDat <T> &cldat, index_t ei) {
     const int cl_from_i = cldat.cl_remap.at (cldat.edges [ei].from),
               cl_to_i = cldat.cl_remap.at (cldat.edges [ei].to);
 
-    full_merge::OneCluster clfrom = cldat.clusters.at (cl_from_i),
-                         clto = cldat.clusters.at (cl_to_i);
+    full_merge::OneCluster <T> clfrom = cldat.clusters.at (cl_from_i),
+                             clto = cldat.clusters.at (cl_to_i);
     clto.n += clfrom.n;
     clto.dist_sum += clfrom.dist_sum;
 
-    if ((cldat.shortest && clfrom.dist_max > clto.dist_max) ||
-            (!cldat.shortest && clfrom.dist_max < clto.dist_max))
+    if (Cmp::better (clto.dist_max, clfrom.dist_max))
         clto.dist_max = clfrom.dist_max;
 
-    std::vector <utils::OneEdge> edges_from = clfrom.edges,
-                                 edges_to = clto.edges;
+    std::vector <utils::OneEdge <T> > edges_from = clfrom.edges,
+                                      edges_to = clto.edges;
     edges_to.insert (edges_to.end (), edges_from.begin (), edges_from.end ());
     clto.edges.clear ();
     clto.edges.shrink_to_fit ();
@@ -153,14 +152,19 @@ full_merge::OneMerge full_merge::merge_one_single (full_merge::FullMergeDat &cld
 // Each merge joins from to to; from remains unchanged but is no longer indexed.
 // Edges nevertheless always refer to original (non-merged) cluster numbers, so
 // need to be re-mapped via the cl_remap
-void full_merge::merge_single (full_merge::FullMergeDat &cldat) {
+template <typename T, typename Cmp>
+void full_merge::merge_single (full_merge::FullMergeDat <T> &cldat,
+        budget::Budget &budget) {
     index_t edgei = 0;
     while (cldat.clusters.size () > 1) {
+        if (budget.check ()) {
+            break;
+        }
         int clfr = cldat.cl_remap.at (cldat.edges [edgei].from),
             clto = cldat.cl_remap.at (cldat.edges [edgei].to);
         if (clfr != clto) {
             full_merge::OneMerge the_merge =
-                full_merge::merge_one_single (cldat, edgei);
+                full_merge::merge_one_single <T, Cmp> (cldat, edgei);
             cldat.merges.push_back (the_merge);
         }
         edgei++;
@@ -169,33 +173,14 @@ void full_merge::merge_single (full_merge::FullMergeDat &cldat) {
     }
 }
 
-bool full_merge::avgdist_sorter_incr (const OneDist &lhs,
-        const OneDist &rhs) {
-    return lhs.value < rhs.value;
-}
-
-bool full_merge::avgdist_sorter_decr (const OneDist &lhs,
-        const OneDist &rhs) {
-    return lhs.value > rhs.value;
-}
-
-bool full_merge::maxdist_sorter_incr (const OneDist &lhs,
-        const OneDist &rhs) {
-    return lhs.d < rhs.d;
-}
-
-bool full_merge::maxdist_sorter_decr (const OneDist &lhs,
-        const OneDist &rhs) {
-    return lhs.d > rhs.d;
-}
-
-void full_merge::fill_avg_dists (full_merge::FullMergeDat &cldat,
-        full_merge::AvgDists &cl_dists) {
+template <typename T, typename Cmp>
+void full_merge::fill_avg_dists (full_merge::FullMergeDat <T> &cldat,
+        full_merge::AvgDists <T> &cl_dists) {
     cl_dists.avg_dists.resize (cldat.edges.size ());
     size_t nc = 0;
     std::unordered_set <std::string> edgenames; // TODO: Remove
     for (auto ei: cldat.edges) {
-        full_merge::OneDist onedist;
+        full_merge::OneDist <T> onedist;
         onedist.cli = ei.from;
         onedist.clj = ei.to;
         onedist.d = ei.dist;
@@ -210,18 +195,15 @@ void full_merge::fill_avg_dists (full_merge::FullMergeDat &cldat,
         cl_dists.avg_dists [nc++] = onedist;
     }
 
-    if (cldat.shortest) {
-        std::sort (cl_dists.avg_dists.begin (), cl_dists.avg_dists.end (),
-                &full_merge::avgdist_sorter_incr);
-    } else {
-        std::sort (cl_dists.avg_dists.begin (), cl_dists.avg_dists.end (),
-                &full_merge::avgdist_sorter_decr);
-    }
+    radix_sort::sort_by (cl_dists.avg_dists,
+            [] (const full_merge::OneDist <T> &x) { return x.value; },
+            Cmp::shortest);
 }
 
 // Fill the cli_map and clj_map entries which map cluster numbers onto sets of
 // indices in cl_dists.avg_dists
-void full_merge::fill_cl_indx_maps (full_merge::AvgDists &cl_dists) {
+template <typename T>
+void full_merge::fill_cl_indx_maps (full_merge::AvgDists <T> &cl_dists) {
     cl_dists.cl_map.clear ();
     for (size_t i = 0; i < cl_dists.avg_dists.size (); i++) {
         indxset_t indxs;
@@ -248,19 +230,17 @@ void full_merge::fill_cl_indx_maps (full_merge::AvgDists &cl_dists) {
 // AvgDists.avg_dists are kept in AvgDists.cli_map and .clj_map. The values of
 // the latter are updated to reflect merges, as are the entries of the new cli
 // in AvgDists.avg_dists.
-full_merge::OneMerge full_merge::merge_avg (full_merge::FullMergeDat &cldat,
-        full_merge::AvgDists &cl_dists)
+template <typename T, typename Cmp>
+full_merge::OneMerge full_merge::merge_avg (full_merge::FullMergeDat <T> &,
+        full_merge::AvgDists <T> &cl_dists)
 {
-    full_merge::OneDist the_dist = cl_dists.avg_dists [0];
+    full_merge::OneDist <T> the_dist = cl_dists.avg_dists [0];
     const double dtot = the_dist.di + the_dist.dj + the_dist.d;
     const size_t ntot = the_dist.ni + the_dist.nj + 1;
     const double average = dtot / static_cast <double> (ntot);
     const int cli = the_dist.cli,
               clj = the_dist.clj;
-    double dmin = INFINITE_DOUBLE; // shortest connecting distance
-    if (!cldat.shortest) {
-        dmin = -dmin;
-    }
+    T dmin = Cmp::template worst <T> (); // shortest connecting distance
 
     indxset_t cli_indx = cl_dists.cl_map.at (cli),
               clj_indx = cl_dists.cl_map.at (clj);
@@ -272,8 +252,7 @@ full_merge::OneMerge full_merge::merge_avg (full_merge::FullMergeDat &cldat,
             cl_dists.avg_dists [i].cli = clj;
         else if (cl_dists.avg_dists [i].clj == cli)
             cl_dists.avg_dists [i].clj = clj;
-        if ((cldat.shortest && cl_dists.avg_dists [i].d < dmin) ||
-                (!cldat.shortest && cl_dists.avg_dists [i].d > dmin))
+        if (Cmp::better (cl_dists.avg_dists [i].d, dmin))
             dmin = cl_dists.avg_dists [i].d;
     }
 
@@ -285,8 +264,7 @@ full_merge::OneMerge full_merge::merge_avg (full_merge::FullMergeDat &cldat,
         } else if (cl_dists.avg_dists [i].clj == cli) {
             cl_dists.avg_dists [i].clj = clj;
         }
-        if ((cldat.shortest && cl_dists.avg_dists [i].d < dmin) ||
-                (!cldat.shortest && cl_dists.avg_dists [i].d > dmin)) {
+        if (Cmp::better (cl_dists.avg_dists [i].d, dmin)) {
             dmin = cl_dists.avg_dists [i].d;
         }
     }
@@ -327,13 +305,9 @@ full_merge::OneMerge full_merge::merge_avg (full_merge::FullMergeDat &cldat,
         cl_dists.avg_dists.erase (cl_dists.avg_dists.begin () + i);
     }
 
-    if (cldat.shortest) {
-        std::sort (cl_dists.avg_dists.begin (), cl_dists.avg_dists.end (),
-                &full_merge::avgdist_sorter_incr);
-    } else {
-        std::sort (cl_dists.avg_dists.begin (), cl_dists.avg_dists.end (),
-                &full_merge::avgdist_sorter_decr);
-    }
+    radix_sort::sort_by (cl_dists.avg_dists,
+            [] (const full_merge::OneDist <T> &x) { return x.value; },
+            Cmp::shortest);
 
     // Finally, update the cl_dists.cli_map & clj_map entries
     fill_cl_indx_maps (cl_dists);
@@ -348,24 +322,30 @@ full_merge::OneMerge full_merge::merge_avg (full_merge::FullMergeDat &cldat,
 
 // Successively merge pairs of clusters which yield the lower average
 // intra-cluster edge distance
-void full_merge::avg (full_merge::FullMergeDat &cldat) {
-    AvgDists cl_dists;
-    full_merge::fill_avg_dists (cldat, cl_dists);
+template <typename T, typename Cmp>
+void full_merge::avg (full_merge::FullMergeDat <T> &cldat,
+        budget::Budget &budget) {
+    AvgDists <T> cl_dists;
+    full_merge::fill_avg_dists <T, Cmp> (cldat, cl_dists);
     full_merge::fill_cl_indx_maps (cl_dists);
 
     while (cl_dists.avg_dists.size () > 1) {
-        full_merge::OneMerge the_merge = full_merge::merge_avg (cldat, cl_dists);
+        if (budget.check ()) {
+            break;
+        }
+        full_merge::OneMerge the_merge = full_merge::merge_avg <T, Cmp> (cldat, cl_dists);
         cldat.merges.push_back (the_merge);
     }
 }
 
-void full_merge::fill_max_dists (full_merge::FullMergeDat &cldat,
-        full_merge::AvgDists &cl_dists) {
+template <typename T, typename Cmp>
+void full_merge::fill_max_dists (full_merge::FullMergeDat <T> &cldat,
+        full_merge::AvgDists <T> &cl_dists) {
     cl_dists.avg_dists.resize (cldat.edges.size ());
     size_t nc = 0;
     std::unordered_set <std::string> edgenames; // TODO: Remove
     for (auto ei: cldat.edges) {
-        full_merge::OneDist onedist;
+        full_merge::OneDist <T> onedist;
         onedist.cli = ei.from;
         onedist.clj = ei.to;
         onedist.d = ei.dist;
@@ -373,32 +353,71 @@ void full_merge::fill_max_dists (full_merge::FullMergeDat &cldat,
         cl_dists.avg_dists [nc++] = onedist;
     }
 
-    if (cldat.shortest) {
-        std::sort (cl_dists.avg_dists.begin (), cl_dists.avg_dists.end (),
-                &full_merge::maxdist_sorter_incr);
-    } else {
-        std::sort (cl_dists.avg_dists.begin (), cl_dists.avg_dists.end (),
-                &full_merge::maxdist_sorter_decr);
-    }
+    radix_sort::sort_by (cl_dists.avg_dists,
+            [] (const full_merge::OneDist <T> &x) { return x.d; },
+            Cmp::shortest);
+}
+
+template <typename T, typename Cmp>
+void full_merge::max (full_merge::FullMergeDat <T> &, budget::Budget &) {
 }
 
-void full_merge::max (full_merge::FullMergeDat &cldat) {
+// Merges so far are replayed into a union-find of cluster numbers, in which
+// each cluster points to the one it was merged into, so that the root of each
+// is the number under which later merges are recorded.
+template <typename T, typename Cmp>
+void full_merge::complete (full_merge::FullMergeDat <T> &cldat) {
+    std::unordered_map <int, int> parent;
+    auto find = [&parent] (int cl) {
+        int root = cl;
+        for (auto p = parent.find (root); p != parent.end ();
+                p = parent.find (root)) {
+            root = p->second;
+        }
+        while (cl != root) {
+            int &p = parent [cl];
+            cl = p;
+            p = root;
+        }
+        return root;
+    };
+
+    for (auto m: cldat.merges) {
+        const int cli = find (m.cli), clj = find (m.clj);
+        if (cli != clj) {
+            parent [cli] = clj;
+        }
+    }
+
+    std::vector <utils::OneEdge <T> > edges = cldat.edges;
+    radix_sort::sort_by (edges,
+            [] (const utils::OneEdge <T> &e) { return e.dist; },
+            Cmp::shortest);
+    for (auto e: edges) {
+        const int cli = find (e.from), clj = find (e.to);
+        if (cli != clj) {
+            parent [cli] = clj;
+            full_merge::OneMerge the_merge;
+            the_merge.cli = cli;
+            the_merge.clj = clj;
+            the_merge.merge_dist = e.dist;
+            cldat.merges.push_back (the_merge);
+        }
+    }
 }
 
 
-full_merge::OneMerge full_merge::merge_max (full_merge::FullMergeDat &cldat,
-        full_merge::AvgDists &cl_dists) {
+template <typename T, typename Cmp>
+full_merge::OneMerge full_merge::merge_max (full_merge::FullMergeDat <T> &,
+        full_merge::AvgDists <T> &cl_dists) {
 
-    full_merge::OneDist the_dist = cl_dists.avg_dists [0];
+    full_merge::OneDist <T> the_dist = cl_dists.avg_dists [0];
     const double dtot = the_dist.di + the_dist.dj + the_dist.d;
     const size_t ntot = the_dist.ni + the_dist.nj + 1;
     const double average = dtot / static_cast <double> (ntot);
     const int cli = the_dist.cli,
               clj = the_dist.clj;
-    double dmin = INFINITE_DOUBLE; // shortest connecting distance
-    if (!cldat.shortest) {
-        dmin = -dmin;
-    }
+    T dmin = Cmp::template worst <T> (); // shortest connecting distance
 
     indxset_t cli_indx = cl_dists.cl_map.at (cli),
               clj_indx = cl_dists.cl_map.at (clj);
@@ -410,8 +429,7 @@ full_merge::OneMerge full_merge::merge_max (full_merge::FullMergeDat &cldat,
             cl_dists.avg_dists [i].cli = clj;
         else if (cl_dists.avg_dists [i].clj == cli)
             cl_dists.avg_dists [i].clj = clj;
-        if ((cldat.shortest && cl_dists.avg_dists [i].d < dmin) ||
-                (!cldat.shortest && cl_dists.avg_dists [i].d > dmin)) {
+        if (Cmp::better (cl_dists.avg_dists [i].d, dmin)) {
             dmin = cl_dists.avg_dists [i].d;
         }
     }
@@ -423,8 +441,7 @@ full_merge::OneMerge full_merge::merge_max (full_merge::FullMergeDat &cldat,
         } else if (cl_dists.avg_dists [i].clj == cli) {
             cl_dists.avg_dists [i].clj = clj;
         }
-        if ((cldat.shortest && cl_dists.avg_dists [i].d < dmin) ||
-                (!cldat.shortest && cl_dists.avg_dists [i].d > dmin)) {
+        if (Cmp::better (cl_dists.avg_dists [i].d, dmin)) {
             dmin = cl_dists.avg_dists [i].d;
         }
     }
@@ -465,13 +482,9 @@ full_merge::OneMerge full_merge::merge_max (full_merge::FullMergeDat &cldat,
         cl_dists.avg_dists.erase (cl_dists.avg_dists.begin () + i);
     }
 
-    if (cldat.shortest) {
-        std::sort (cl_dists.avg_dists.begin (), cl_dists.avg_dists.end (),
-                &full_merge::avgdist_sorter_incr);
-    } else {
-        std::sort (cl_dists.avg_dists.begin (), cl_dists.avg_dists.end (),
-                &full_merge::avgdist_sorter_decr);
-    }
+    radix_sort::sort_by (cl_dists.avg_dists,
+            [] (const full_merge::OneDist <T> &x) { return x.value; },
+            Cmp::shortest);
 
     // Finally, update the cl_dists.cli_map & clj_map entries
     fill_cl_indx_maps (cl_dists);
@@ -485,38 +498,62 @@ full_merge::OneMerge full_merge::merge_max (full_merge::FullMergeDat &cldat,
     return the_merge;
 }
 
+template <typename T, typename Cmp>
+std::vector <full_merge::OneMerge> full_merge::merge_all (
+        const Rcpp::DataFrame &gr,
+        const std::string &linkage,
+        budget::Budget &budget)
+{
+    full_merge::FullMergeDat <T> clmerge_dat;
+    full_merge::init <T, Cmp> (gr, clmerge_dat);
+
+    if (utils::strfound (linkage, "single")) {
+        full_merge::merge_single <T, Cmp> (clmerge_dat, budget);
+    } else if (utils::strfound (linkage, "average")) {
+        full_merge::avg <T, Cmp> (clmerge_dat, budget);
+    } else if (utils::strfound (linkage, "max")) {
+        full_merge::max <T, Cmp> (clmerge_dat, budget);
+    } else {
+        Rcpp::stop ("linkage not found for full_merge");
+    }
+
+    if (budget.expired ()) {
+        full_merge::complete <T, Cmp> (clmerge_dat);
+    }
+
+    return clmerge_dat.merges;
+}
+
 //' rcpp_full_merge
 //'
 //' Merge clusters generated by rcpp_full_initial to full hierarchy of all
 //' possible merges.
 //'
+//' @param time_budget Maximal time in seconds, with `Inf` for no limit
+//'
+//' @return Matrix of merges, with a "partial" attribute which is `TRUE` if the
+//' time budget expired before all merges were made, in which case the
+//' remaining merges follow single linkage.
 //' @noRd
 // [[Rcpp::export]]
 Rcpp::NumericMatrix rcpp_full_merge (
         const Rcpp::DataFrame gr,
         const std::string linkage,
-        const bool shortest)
+        const bool shortest,
+        const std::string precision,
+        const double time_budget)
 {
-    full_merge::FullMergeDat clmerge_dat;
-    clmerge_dat.shortest = shortest;
-    full_merge::init (gr, clmerge_dat);
-
-    if (utils::strfound (linkage, "single")) {
-        full_merge::merge_single (clmerge_dat);
-    } else if (utils::strfound (linkage, "average")) {
-        full_merge::avg (clmerge_dat);
-    } else if (utils::strfound (linkage, "max")) {
-        full_merge::max (clmerge_dat);
-    } else {
-        Rcpp::stop ("linkage not found for full_merge");
-    }
+    budget::Budget budget (time_budget);
+    std::vector <full_merge::OneMerge> merges =
+        policy::dispatch <full_merge::MergeAll> (precision, shortest, gr,
+                linkage, budget);
 
-    const size_t n = clmerge_dat.merges.size ();
+    const size_t n = merges.size ();
     Rcpp::NumericMatrix res (static_cast <int> (n), 3);
     for (size_t i = 0; i < n; i++) {
-        res (i, 0) = clmerge_dat.merges [i].cli;
-        res (i, 1) = clmerge_dat.merges [i].clj;
-        res (i, 2) = clmerge_dat.merges [i].merge_dist;
+        res (i, 0) = merges [i].cli;
+        res (i, 1) = merges [i].clj;
+        res (i, 2) = merges [i].merge_dist;
     }
 
     std::vector <std::string> colnames (3);
@@ -526,6 +563,7 @@ Rcpp::NumericMatrix rcpp_full_merge (
     Rcpp::List dimnames (2);
     dimnames (1) = colnames;
     res.attr ("dimnames") = dimnames;
+    res.attr ("partial") = budget.expired ();
 
     return res;
 }
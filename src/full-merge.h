@@ -3,6 +3,7 @@
 #include <deque>
 
 #include "utils.h"
+#include "budget.h"
 
 // Merge the clusters generated by the rcpp_full_initial. Separate class and
 // routines to allow results from rcpp_full_initial to be returned and cached
@@ -10,11 +11,17 @@
 
 namespace full_merge {
 
+// All structures are templated on the distance type, T, which is either float
+// or double. Sums of distances are always accumulated in double precision.
+// Functions are additionally templated on a comparison policy, Cmp, which is
+// either policy::Shortest or policy::Longest.
+template <typename T>
 struct OneCluster {
     int id;
     size_t n;
-    double dist_sum, dist_max;
-    std::vector <utils::OneEdge> edges;
+    double dist_sum;
+    T dist_max;
+    std::vector <utils::OneEdge <T> > edges;
 };
 
 struct OneMerge {
@@ -22,48 +29,80 @@ struct OneMerge {
     double merge_dist;
 };
 
+template <typename T>
 struct FullMergeDat {
-    bool shortest;
     std::unordered_map <int, int> cl_remap;
     std::unordered_map <int, intset_t> cl_members;
-    std::unordered_map <int, OneCluster> clusters;
-    std::vector <utils::OneEdge> edges; // edges between clusters
+    std::unordered_map <int, OneCluster <T> > clusters;
+    std::vector <utils::OneEdge <T> > edges; // edges between clusters
     std::vector <OneMerge> merges;
 };
 
+template <typename T>
 struct OneDist {
     int cli, clj;
     size_t ni, nj;
-    double di, dj, d, value; 
+    double di, dj, value;
+    T d;
     // di, dj are dist_sums, d is min dist of connecting edge
 };
 
+template <typename T>
 struct AvgDists {
     std::unordered_map <int, indxset_t> cl_map;
-    std::deque <OneDist> avg_dists;
+    std::deque <OneDist <T> > avg_dists;
 };
 
-void init (const Rcpp::DataFrame &gr, FullMergeDat &cldat);
+template <typename T, typename Cmp>
+void init (const Rcpp::DataFrame &gr, FullMergeDat <T> &cldat);
 
-OneMerge merge_one_single (FullMergeDat &cldat, index_t ei);
-void merge_single (FullMergeDat &cldat);
+template <typename T, typename Cmp>
+OneMerge merge_one_single (FullMergeDat <T> &cldat, index_t ei);
+template <typename T, typename Cmp>
+void merge_single (FullMergeDat <T> &cldat, budget::Budget &budget);
 
-bool avgdist_sorter_incr (const OneDist &lhs, const OneDist &rhs);
-bool avgdist_sorter_decr (const OneDist &lhs, const OneDist &rhs);
-void fill_avg_dists (FullMergeDat &cldat, AvgDists &cl_dists);
-void fill_cl_indx_maps (AvgDists &cl_dists);
-OneMerge merge_avg (FullMergeDat &cldat, AvgDists &cl_dists);
-void avg (FullMergeDat &cldat);
+template <typename T, typename Cmp>
+void fill_avg_dists (FullMergeDat <T> &cldat, AvgDists <T> &cl_dists);
+template <typename T>
+void fill_cl_indx_maps (AvgDists <T> &cl_dists);
+template <typename T, typename Cmp>
+OneMerge merge_avg (FullMergeDat <T> &cldat, AvgDists <T> &cl_dists);
+template <typename T, typename Cmp>
+void avg (FullMergeDat <T> &cldat, budget::Budget &budget);
 
-bool maxdist_sorter_incr (const OneDist &lhs, const OneDist &rhs);
-bool maxdist_sorter_decr (const OneDist &lhs, const OneDist &rhs);
-void fill_max_dists (FullMergeDat &cldat, AvgDists &cl_dists);
-OneMerge merge_max (FullMergeDat &cldat, AvgDists &cl_dists);
-void max (FullMergeDat &cldat);
+template <typename T, typename Cmp>
+void fill_max_dists (FullMergeDat <T> &cldat, AvgDists <T> &cl_dists);
+template <typename T, typename Cmp>
+OneMerge merge_max (FullMergeDat <T> &cldat, AvgDists <T> &cl_dists);
+template <typename T, typename Cmp>
+void max (FullMergeDat <T> &cldat, budget::Budget &budget);
+
+// Complete the hierarchy once a time budget has expired, by merging all
+// remaining pairs of clusters in order of the strongest edges between them, as
+// for single linkage.
+template <typename T, typename Cmp>
+void complete (FullMergeDat <T> &cldat);
+
+// Merging stops once `budget` expires, after which the hierarchy is completed
+// with `complete`, and `budget.expired ()` is `true`.
+template <typename T, typename Cmp>
+std::vector <OneMerge> merge_all (const Rcpp::DataFrame &gr,
+        const std::string &linkage, budget::Budget &budget);
+
+// Target for policy::dispatch
+struct MergeAll {
+    template <typename T, typename Cmp>
+    static std::vector <OneMerge> run (const Rcpp::DataFrame &gr,
+            const std::string &linkage, budget::Budget &budget) {
+        return merge_all <T, Cmp> (gr, linkage, budget);
+    }
+};
 
 } // end namespace full_merge
 
 Rcpp::NumericMatrix rcpp_full_merge (
         const Rcpp::DataFrame gr,
         const std::string method,
-        const bool shortest);
+        const bool shortest,
+        const std::string precision,
+        const double time_budget);
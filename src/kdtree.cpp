@@ -0,0 +1,473 @@
+#include "common.h"
+#include "kdtree.h"
+#include "edge-dists.h"
+#include "threads.h"
+
+namespace {
+
+// Order of candidate edges from a query point, `q`, by distance, and then by
+// (from, to) with from < to.
+bool better_edge (const double d1, const size_t q1, const size_t p1,
+        const double d2, const size_t q2, const size_t p2) {
+    if (d1 != d2) {
+        return d1 < d2;
+    }
+    const size_t a1 = std::min (q1, p1), a2 = std::min (q2, p2);
+    if (a1 != a2) {
+        return a1 < a2;
+    }
+    return std::max (q1, p1) < std::max (q2, p2);
+}
+
+size_t find (std::vector <size_t> &parent, size_t i) {
+    while (parent [i] != i) {
+        parent [i] = parent [parent [i]];
+        i = parent [i];
+    }
+    return i;
+}
+
+void check_finite (const Rcpp::NumericMatrix &xy) {
+    const double *x = xy.begin ();
+    const R_xlen_t len = static_cast <R_xlen_t> (xy.nrow ()) * xy.ncol ();
+    for (R_xlen_t i = 0; i < len; i++) {
+        if (!std::isfinite (x [i])) {
+            Rcpp::stop ("Coordinates must all be finite");
+        }
+    }
+}
+
+} // end anonymous namespace
+
+kdtree::Tree::Tree (const double *x_in, const size_t n_in,
+        const size_t p_in) : x (x_in), n (n_in), p (p_in), index (n_in) {
+
+    for (size_t i = 0; i < n; i++) {
+        index [i] = i;
+    }
+    if (n > 0) {
+        build (0, n);
+    }
+}
+
+size_t kdtree::Tree::build (const size_t begin, const size_t end) {
+
+    const size_t id = nodes.size ();
+    kdtree::Node node;
+    node.begin = begin;
+    node.end = end;
+    nodes.push_back (node);
+
+    size_t split_dim = 0;
+    double split_width = 0.0;
+    for (size_t c = 0; c < p; c++) {
+        double cmin = x [index [begin] + c * n], cmax = cmin;
+        for (size_t i = begin + 1; i < end; i++) {
+            const double v = x [index [i] + c * n];
+            cmin = std::min (cmin, v);
+            cmax = std::max (cmax, v);
+        }
+        lo.push_back (cmin);
+        hi.push_back (cmax);
+        if (cmax - cmin > split_width) {
+            split_dim = c;
+            split_width = cmax - cmin;
+        }
+    }
+
+    // Nodes of identical points are never split
+    if (end - begin > kdtree::LEAF_SIZE && split_width > 0.0) {
+        const size_t mid = begin + (end - begin) / 2;
+        const double *xc = x + split_dim * n;
+        std::nth_element (index.begin () + static_cast <long> (begin),
+                index.begin () + static_cast <long> (mid),
+                index.begin () + static_cast <long> (end),
+                [xc] (const size_t a, const size_t b) {
+                    return xc [a] < xc [b] || (xc [a] == xc [b] && a < b); });
+        const size_t left = build (begin, mid);
+        const size_t right = build (mid, end);
+        nodes [id].left = left;
+        nodes [id].right = right;
+    }
+
+    return id;
+}
+
+// Gaps between point and box are calculated with the same subtraction as
+// distances between points, and summed in the same order, so that rounding
+// never makes a bound exceed any actual distance.
+double kdtree::Tree::min_dist (const size_t node, const size_t q) const {
+    const double *nlo = lo.data () + node * p, *nhi = hi.data () + node * p;
+    double s = 0.0;
+    for (size_t c = 0; c < p; c++) {
+        const double v = x [q + c * n];
+        double dev = 0.0;
+        if (v < nlo [c]) {
+            dev = nlo [c] - v;
+        } else if (v > nhi [c]) {
+            dev = v - nhi [c];
+        }
+        s += dev * dev;
+    }
+    return std::sqrt (s);
+}
+
+double kdtree::Tree::max_dist (const size_t node, const size_t q) const {
+    const double *nlo = lo.data () + node * p, *nhi = hi.data () + node * p;
+    double s = 0.0;
+    for (size_t c = 0; c < p; c++) {
+        const double v = x [q + c * n];
+        const double dev = std::max (std::abs (v - nlo [c]),
+                std::abs (nhi [c] - v));
+        s += dev * dev;
+    }
+    return std::sqrt (s);
+}
+
+// Points with indices >= `limit` are skipped, which leaves all bounds valid.
+template <typename Cmp>
+void kdtree::Tree::search (const size_t node, const size_t q,
+        std::vector <kdtree::Neighbour> &best, const size_t k,
+        const size_t limit) const {
+
+    const kdtree::Node &nd = nodes [node];
+
+    if (nd.left == kdtree::NONE) {
+        for (size_t j = nd.begin; j < nd.end; j++) {
+            const size_t i = index [j];
+            if (i >= limit) {
+                continue;
+            }
+            const kdtree::Neighbour nb {dist (q, i), i};
+            if (best.size () == k && !(Cmp::better (nb.d, best.back ().d) ||
+                        (nb.d == best.back ().d && nb.i < best.back ().i))) {
+                continue;
+            }
+            auto it = best.begin ();
+            while (it != best.end () && (Cmp::better (it->d, nb.d) ||
+                        (it->d == nb.d && it->i < nb.i))) {
+                it++;
+            }
+            best.insert (it, nb);
+            if (best.size () > k) {
+                best.pop_back ();
+            }
+        }
+        return;
+    }
+
+    // Bounds on distances to each child, with the child which may hold
+    // better neighbours searched first.
+    double bl, br;
+    if (Cmp::shortest) {
+        bl = min_dist (nd.left, q);
+        br = min_dist (nd.right, q);
+    } else {
+        bl = max_dist (nd.left, q);
+        br = max_dist (nd.right, q);
+    }
+    const bool left_first = !Cmp::better (br, bl);
+    const size_t first = left_first ? nd.left : nd.right,
+          second = left_first ? nd.right : nd.left;
+    const double bfirst = left_first ? bl : br,
+          bsecond = left_first ? br : bl;
+
+    if (best.size () < k || !Cmp::better (best.back ().d, bfirst)) {
+        search <Cmp> (first, q, best, k, limit);
+    }
+    if (best.size () < k || !Cmp::better (best.back ().d, bsecond)) {
+        search <Cmp> (second, q, best, k, limit);
+    }
+}
+
+template <typename Cmp>
+std::vector <size_t> kdtree::Tree::knn (const size_t k,
+        const int nthreads) const {
+
+    std::vector <size_t> res (n * k, kdtree::NONE);
+    if (n == 0) {
+        return res;
+    }
+    const size_t kk = std::min (k, n);
+
+    threads::parallel_for (n, nthreads,
+            [&] (const size_t begin, const size_t end) {
+                std::vector <kdtree::Neighbour> best;
+                best.reserve (kk + 1);
+                for (size_t q = begin; q < end; q++) {
+                    best.clear ();
+                    search <Cmp> (0, q, best, kk, n);
+                    for (size_t j = 0; j < best.size (); j++) {
+                        res [q * k + j] = best [j].i;
+                    }
+                }
+            });
+
+    return res;
+}
+
+template std::vector <size_t> kdtree::Tree::knn <policy::Shortest> (
+        const size_t k, const int nthreads) const;
+template std::vector <size_t> kdtree::Tree::knn <policy::Longest> (
+        const size_t k, const int nthreads) const;
+
+std::vector <kdtree::Neighbour> kdtree::Tree::nearest (const size_t q,
+        const size_t k, const size_t limit) const {
+
+    // Search for one more neighbour in case `q` is among the first `limit`:
+    const size_t lim = std::min (limit, n),
+          kk = std::min (k + (q < lim ? 1 : 0), lim);
+    std::vector <kdtree::Neighbour> best;
+    if (kk == 0) {
+        return best;
+    }
+    best.reserve (kk + 1);
+    search <policy::Shortest> (0, q, best, kk, lim);
+
+    best.erase (std::remove_if (best.begin (), best.end (),
+                [q] (const kdtree::Neighbour &nb) { return nb.i == q; }),
+            best.end ());
+    if (best.size () > k) {
+        best.resize (k);
+    }
+
+    return best;
+}
+
+void kdtree::Tree::search_other (const size_t node, const size_t q,
+        const std::vector <size_t> &comp,
+        const std::vector <size_t> &node_comp,
+        kdtree::Neighbour &best) const {
+
+    const kdtree::Node &nd = nodes [node];
+
+    if (nd.left == kdtree::NONE) {
+        for (size_t j = nd.begin; j < nd.end; j++) {
+            const size_t i = index [j];
+            if (comp [i] == comp [q]) {
+                continue;
+            }
+            const double d = dist (q, i);
+            if (best.i == kdtree::NONE ||
+                    better_edge (d, q, i, best.d, q, best.i)) {
+                best.d = d;
+                best.i = i;
+            }
+        }
+        return;
+    }
+
+    const double bl = min_dist (nd.left, q), br = min_dist (nd.right, q);
+    const bool left_first = bl <= br;
+    const size_t first = left_first ? nd.left : nd.right,
+          second = left_first ? nd.right : nd.left;
+    const double bfirst = left_first ? bl : br,
+          bsecond = left_first ? br : bl;
+
+    if (node_comp [first] != comp [q] &&
+            (best.i == kdtree::NONE || bfirst <= best.d)) {
+        search_other (first, q, comp, node_comp, best);
+    }
+    if (node_comp [second] != comp [q] &&
+            (best.i == kdtree::NONE || bsecond <= best.d)) {
+        search_other (second, q, comp, node_comp, best);
+    }
+}
+
+std::vector <kdtree::Edge> kdtree::Tree::mst (const int nthreads) const {
+
+    std::vector <kdtree::Edge> tree;
+    if (n < 2) {
+        return tree;
+    }
+
+    std::vector <size_t> parent (n), comp (n), node_comp (nodes.size ());
+    for (size_t i = 0; i < n; i++) {
+        parent [i] = i;
+    }
+    std::vector <kdtree::Neighbour> nbs (n);
+    std::vector <kdtree::Edge> cheapest (n);
+
+    bool merged = true;
+    while (merged) {
+        for (size_t i = 0; i < n; i++) {
+            comp [i] = find (parent, i);
+        }
+        // Component of all points in each node, or NONE. Children always
+        // follow their parents in `nodes`.
+        for (size_t j = nodes.size (); j-- > 0; ) {
+            const kdtree::Node &nd = nodes [j];
+            if (nd.left == kdtree::NONE) {
+                node_comp [j] = comp [index [nd.begin]];
+                for (size_t i = nd.begin + 1; i < nd.end; i++) {
+                    if (comp [index [i]] != node_comp [j]) {
+                        node_comp [j] = kdtree::NONE;
+                        break;
+                    }
+                }
+            } else {
+                node_comp [j] = node_comp [nd.left] == node_comp [nd.right] ?
+                    node_comp [nd.left] : kdtree::NONE;
+            }
+        }
+        if (node_comp [0] != kdtree::NONE) {
+            break;
+        }
+
+        // Nearest neighbour of each point in a different component:
+        threads::parallel_for (n, nthreads,
+                [&] (const size_t begin, const size_t end) {
+                    for (size_t q = begin; q < end; q++) {
+                        nbs [q].d = 0.0;
+                        nbs [q].i = kdtree::NONE;
+                        search_other (0, q, comp, node_comp, nbs [q]);
+                    }
+                });
+
+        // Cheapest edge leaving each component:
+        for (size_t i = 0; i < n; i++) {
+            cheapest [i].from = kdtree::NONE;
+        }
+        for (size_t q = 0; q < n; q++) {
+            if (nbs [q].i == kdtree::NONE) {
+                continue;
+            }
+            kdtree::Edge &e = cheapest [comp [q]];
+            if (e.from == kdtree::NONE ||
+                    better_edge (nbs [q].d, q, nbs [q].i, e.d, e.from, e.to)) {
+                e.from = std::min (q, nbs [q].i);
+                e.to = std::max (q, nbs [q].i);
+                e.d = nbs [q].d;
+            }
+        }
+
+        // All of which are added at once, with edges selected by both of the
+        // components they join only added once.
+        merged = false;
+        for (size_t c = 0; c < n; c++) {
+            const kdtree::Edge &e = cheapest [c];
+            if (e.from == kdtree::NONE) {
+                continue;
+            }
+            const size_t cf = find (parent, e.from), ct = find (parent, e.to);
+            if (cf != ct) {
+                parent [std::max (cf, ct)] = std::min (cf, ct);
+                tree.push_back (e);
+                merged = true;
+            }
+        }
+    }
+
+    std::sort (tree.begin (), tree.end (),
+            [] (const kdtree::Edge &a, const kdtree::Edge &b) {
+                return a.from < b.from || (a.from == b.from && a.to < b.to); });
+
+    return tree;
+}
+
+//' rcpp_knn
+//'
+//' Nearest or farthest neighbours of each point, including itself, from a k-d
+//' tree of coordinates.
+//'
+//' @param xy Numeric matrix of coordinates
+//' @param k Number of neighbours
+//' @param nthreads Number of threads, with values <= 0 using all available
+//'
+//' @return A `k`-by-n matrix of 1-indexed neighbours of each point, in
+//' columns, as for `apply (as.matrix (dist (xy)), 2, order)` truncated to `k`
+//' rows, with NA where `k` exceeds the number of points.
+//' @noRd
+// [[Rcpp::export]]
+Rcpp::IntegerMatrix rcpp_knn (
+        const Rcpp::NumericMatrix xy,
+        const int k,
+        const bool shortest,
+        const int nthreads) {
+
+    check_finite (xy);
+    if (k < 0) {
+        Rcpp::stop ("k must be non-negative");
+    }
+    const size_t n = static_cast <size_t> (xy.nrow ()),
+          p = static_cast <size_t> (xy.ncol ()),
+          ku = static_cast <size_t> (k);
+
+    const kdtree::Tree tree (xy.begin (), n, p);
+    const std::vector <size_t> nbs = shortest ?
+        tree.knn <policy::Shortest> (ku, nthreads) :
+        tree.knn <policy::Longest> (ku, nthreads);
+
+    Rcpp::IntegerMatrix res (k, xy.nrow ());
+    for (size_t i = 0; i < nbs.size (); i++) {
+        res [static_cast <R_xlen_t> (i)] = nbs [i] == kdtree::NONE ?
+            NA_INTEGER : static_cast <int> (nbs [i]) + 1;
+    }
+
+    return res;
+}
+
+//' rcpp_emst
+//'
+//' Euclidean minimal spanning tree of coordinates, from a k-d tree.
+//'
+//' @param xy Numeric matrix of coordinates
+//' @param nthreads Number of threads, with values <= 0 using all available
+//'
+//' @return `data.frame` of 1-indexed (from, to) tree edges, with from < to, and
+//' distances, sorted by (from, to).
+//' @noRd
+// [[Rcpp::export]]
+Rcpp::DataFrame rcpp_emst (
+        const Rcpp::NumericMatrix xy,
+        const int nthreads) {
+
+    check_finite (xy);
+    const kdtree::Tree tree (xy.begin (), static_cast <size_t> (xy.nrow ()),
+            static_cast <size_t> (xy.ncol ()));
+    const std::vector <kdtree::Edge> edges = tree.mst (nthreads);
+
+    const R_xlen_t m = static_cast <R_xlen_t> (edges.size ());
+    Rcpp::IntegerVector from (m), to (m);
+    Rcpp::NumericVector d (m);
+    for (R_xlen_t i = 0; i < m; i++) {
+        const kdtree::Edge &e = edges [static_cast <size_t> (i)];
+        from [i] = static_cast <int> (e.from) + 1;
+        to [i] = static_cast <int> (e.to) + 1;
+        d [i] = e.d;
+    }
+
+    return Rcpp::DataFrame::create (
+        Rcpp::Named ("from") = from,
+        Rcpp::Named ("to") = to,
+        Rcpp::Named ("d") = d,
+        Rcpp::_["stringsAsFactors"] = false);
+}
+
+//' rcpp_xy_dists
+//'
+//' Euclidean distances between coordinates along edges, calculated in the same
+//' way as `stats::dist`.
+//'
+//' @param xy Numeric matrix of coordinates
+//' @param from, to 1-indexed vertex numbers of edges
+//' @noRd
+// [[Rcpp::export]]
+Rcpp::NumericVector rcpp_xy_dists (
+        const Rcpp::NumericMatrix xy,
+        const Rcpp::IntegerVector from,
+        const Rcpp::IntegerVector to) {
+
+    edge_dists::check_edges (from, to, xy.nrow ());
+    const size_t n = static_cast <size_t> (xy.nrow ()),
+          p = static_cast <size_t> (xy.ncol ());
+
+    Rcpp::NumericVector d (from.size ());
+    for (R_xlen_t k = 0; k < from.size (); k++) {
+        d [k] = kdtree::dist (xy.begin (), n, p,
+                static_cast <size_t> (from [k] - 1),
+                static_cast <size_t> (to [k] - 1));
+    }
+
+    return d;
+}
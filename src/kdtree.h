@@ -0,0 +1,124 @@
+#pragma once
+
+#include "policies.h"
+
+// --------- K-D TREES OF COORDINATES ----------------
+
+/* Nearest neighbours and minimal spanning trees of points are found here from
+ * a k-d tree of their coordinates, rather than from a full matrix of
+ * distances between all pairs of points. Each node of the tree holds the
+ * bounding box of its points, which is split at the median of its widest
+ * dimension, down to leaves of at most LEAF_SIZE points.
+ *
+ * Distances are calculated in the same way as `stats::dist`, and lower and
+ * upper bounds on distances to the points within each box in the same order
+ * of operations, so that the bounds are never violated by rounding. Results
+ * are then identical to those calculated from a full distance matrix,
+ * including the resolution of ties, which are broken by vertex number.
+ *
+ * Minimal spanning trees are calculated with Boruvka's algorithm, in which the
+ * nearest neighbour of each point within a different component is found in
+ * each round, with searches pruned for all nodes whose points lie within a
+ * single component.
+ */
+
+namespace kdtree {
+
+constexpr size_t LEAF_SIZE = 16;
+constexpr size_t NONE = std::numeric_limits <size_t>::max ();
+
+struct Node {
+    size_t begin, end; // range of points in `Tree::index`
+    size_t left = NONE, right = NONE;
+};
+
+// A neighbouring point, `i`, at distance, `d`
+struct Neighbour {
+    double d;
+    size_t i;
+};
+
+// An edge of a minimal spanning tree, with from < to, both 0-indexed
+struct Edge {
+    size_t from, to;
+    double d;
+};
+
+// Distance between rows `i` and `j` of column-major (n x p) coordinates,
+// summed in the same order as `stats::dist`
+inline double dist (const double *x, const size_t n, const size_t p,
+        const size_t i, const size_t j) {
+    double s = 0.0;
+    for (size_t c = 0; c < p; c++) {
+        const double dev = x [i + c * n] - x [j + c * n];
+        s += dev * dev;
+    }
+    return std::sqrt (s);
+}
+
+class Tree {
+    const double *x; // column-major coordinates, as for R matrices
+    size_t n, p;
+
+    std::vector <size_t> index;
+    std::vector <Node> nodes;
+    std::vector <double> lo, hi; // bounding boxes, p values for each node
+
+    size_t build (const size_t begin, const size_t end);
+
+    template <typename Cmp>
+    void search (const size_t node, const size_t q,
+            std::vector <Neighbour> &best, const size_t k,
+            const size_t limit) const;
+
+    void search_other (const size_t node, const size_t q,
+            const std::vector <size_t> &comp,
+            const std::vector <size_t> &node_comp,
+            Neighbour &best) const;
+
+public:
+    Tree (const double *x_in, const size_t n_in, const size_t p_in);
+
+    double dist (const size_t i, const size_t j) const {
+        return kdtree::dist (x, n, p, i, j);
+    }
+
+    // Bounds on the distance from point `q` to any point in `node`
+    double min_dist (const size_t node, const size_t q) const;
+    double max_dist (const size_t node, const size_t q) const;
+
+    // The `k` nearest (for policy::Shortest) or farthest (for policy::Longest)
+    // neighbours of every point, including the point itself, in order of
+    // distance, and then of vertex number. Returns an n-by-k matrix stored
+    // row-major, with NONE where k > n.
+    template <typename Cmp>
+    std::vector <size_t> knn (const size_t k, const int nthreads) const;
+
+    // The `k` nearest neighbours of point `q` out of the first `limit` points,
+    // excluding `q` itself if it is one of those, in order of distance, and
+    // then of vertex number.
+    std::vector <Neighbour> nearest (const size_t q, const size_t k,
+            const size_t limit) const;
+
+    // Minimal spanning tree (or forest) of Euclidean distances, sorted by
+    // (from, to). Ties are broken by (from, to), as for Kruskal's algorithm
+    // applied to edges sorted by (d, from, to).
+    std::vector <Edge> mst (const int nthreads) const;
+};
+
+} // end namespace kdtree
+
+Rcpp::IntegerMatrix rcpp_knn (
+        const Rcpp::NumericMatrix xy,
+        const int k,
+        const bool shortest,
+        const int nthreads);
+
+Rcpp::DataFrame rcpp_emst (
+        const Rcpp::NumericMatrix xy,
+        const int nthreads);
+
+Rcpp::NumericVector rcpp_xy_dists (
+        const Rcpp::NumericMatrix xy,
+        const Rcpp::IntegerVector from,
+        const Rcpp::IntegerVector to);
@@ -1,8 +1,64 @@
 #include "mst.h"
+#include "radix-sort.h"
+#include "threads.h"
+
+namespace {
+
+constexpr size_t NO_EDGE = std::numeric_limits <size_t>::max ();
+
+// Union-find of vertices into components
+struct Components {
+    std::vector <size_t> parent;
+
+    explicit Components (const size_t n) : parent (n) {
+        for (size_t i = 0; i < n; i++) {
+            parent [i] = i;
+        }
+    }
+
+    size_t find (size_t i) {
+        while (parent [i] != i) {
+            parent [i] = parent [parent [i]];
+            i = parent [i];
+        }
+        return i;
+    }
+
+    // Join the components of i and j, returning false if they are already the
+    // same component.
+    bool join (const size_t i, const size_t j) {
+        const size_t ci = find (i), cj = find (j);
+        if (ci == cj) {
+            return false;
+        }
+        parent [std::max (ci, cj)] = std::min (ci, cj);
+        return true;
+    }
+};
+
+// Maximal vertex number + 1
+size_t num_vertices (const std::vector <MSTEdge> &edges) {
+    size_t nverts = 0;
+    for (auto e: edges) {
+        nverts = std::max (nverts, static_cast <size_t> (
+                    std::max (e.from, e.to)) + 1);
+    }
+    return nverts;
+}
+
+void atomic_min (std::atomic <size_t> &a, const size_t x) {
+    size_t current = a.load (std::memory_order_relaxed);
+    while (x < current && !a.compare_exchange_weak (current, x,
+                std::memory_order_relaxed)) {
+    }
+}
+
+} // end anonymous namespace
 
 std::vector <MSTEdge> mst (Rcpp::IntegerVector from,
         Rcpp::IntegerVector to,
-        Rcpp::NumericVector d) {
+        Rcpp::NumericVector d,
+        const int nthreads) {
     const size_t n = static_cast <size_t> (from.size ());
 
     std::vector <MSTEdge> edges (n);
@@ -14,49 +70,119 @@ std::vector <MSTEdge> mst (Rcpp::IntegerVector from,
         edges [i] = ei;
     }
 
-    std::vector <size_t> cl_id (n);
-    for (size_t i = 0; i < n; i++) {
-        cl_id [i] = i;
+    return mst (edges, nthreads);
+}
+
+std::vector <MSTEdge> mst (std::vector <MSTEdge> edges, const int nthreads) {
+    const size_t n = edges.size ();
+
+    if (threads::num_threads (nthreads, n) > 1) {
+        return mst_boruvka (edges, nthreads);
     }
 
-    std::sort (edges.begin (), edges.end ());
+    radix_sort::sort_by (edges,
+            [] (const MSTEdge &e) { return e.dist; }, true);
 
+    Components components (num_vertices (edges));
     std::vector <MSTEdge> result;
 
     for (MSTEdge e : edges) {
-        const size_t cl_from = cl_id [static_cast <size_t> (e.from)],
-            cl_to = cl_id [static_cast <size_t> (e.to)];
-
-        if (cl_from != cl_to) {
+        if (components.join (static_cast <size_t> (e.from),
+                    static_cast <size_t> (e.to))) {
             result.push_back (e);
+        }
+    }
 
-            const size_t cl_min = std::min (cl_from, cl_to),
-                  cl_max = std::max (cl_from, cl_to);
+    return result;
+}
+
+std::vector <MSTEdge> mst_boruvka (const std::vector <MSTEdge> &edges,
+        const int nthreads) {
+    const size_t n = edges.size ();
 
-            for (size_t i = 0; i < n; i++) {
-                if (cl_id [i] == cl_max) {
-                    cl_id [i] = cl_min;
-                }
+    std::vector <double> d (n);
+    for (size_t i = 0; i < n; i++) {
+        d [i] = edges [i].dist;
+    }
+    const size_t nverts = num_vertices (edges);
+
+    // Edges are compared by their ranks in stably sorted order. This is a
+    // strict order, under which the tree is unique, and identical to that
+    // found by Kruskal's algorithm.
+    const std::vector <size_t> index = radix_sort::order (d.data (), n, true,
+            nthreads);
+    std::vector <size_t> rank (n);
+    for (size_t r = 0; r < n; r++) {
+        rank [index [r]] = r;
+    }
+
+    Components components (nverts);
+    std::vector <size_t> comp (nverts);
+    std::vector <std::atomic <size_t> > cheapest (nverts);
+    std::vector <size_t> tree_ranks;
+
+    bool merged = true;
+    while (merged) {
+        for (size_t v = 0; v < nverts; v++) {
+            comp [v] = components.find (v);
+            cheapest [v].store (NO_EDGE, std::memory_order_relaxed);
+        }
+
+        // Cheapest edge leaving each component:
+        threads::parallel_for (n, nthreads,
+                [&] (const size_t begin, const size_t end) {
+                    for (size_t i = begin; i < end; i++) {
+                        const size_t cf = comp [static_cast <size_t> (
+                                    edges [i].from)],
+                              ct = comp [static_cast <size_t> (
+                                    edges [i].to)];
+                        if (cf != ct) {
+                            atomic_min (cheapest [cf], rank [i]);
+                            atomic_min (cheapest [ct], rank [i]);
+                        }
+                    }
+                });
+
+        // All of which can be added at once, with edges selected by both of
+        // the components they join only added once.
+        merged = false;
+        for (size_t v = 0; v < nverts; v++) {
+            const size_t r = cheapest [v].load (std::memory_order_relaxed);
+            if (comp [v] != v || r == NO_EDGE) {
+                continue;
+            }
+            const MSTEdge &e = edges [index [r]];
+            if (components.join (static_cast <size_t> (e.from),
+                        static_cast <size_t> (e.to))) {
+                tree_ranks.push_back (r);
+                merged = true;
             }
         }
     }
 
+    std::sort (tree_ranks.begin (), tree_ranks.end ());
+    std::vector <MSTEdge> result;
+    result.reserve (tree_ranks.size ());
+    for (auto r: tree_ranks) {
+        result.push_back (edges [index [r]]);
+    }
+
     return result;
 }
 
-
 //' rcpp_mst
 //'
 //' Minimum spanning tree
 //'
+//' @param nthreads Number of threads, with values <= 0 using all available
 //' @noRd
 // [[Rcpp::export]]
-Rcpp::DataFrame rcpp_mst (Rcpp::DataFrame input) {
+Rcpp::DataFrame rcpp_mst (Rcpp::DataFrame input, const int nthreads) {
     Rcpp::IntegerVector from = input ["from"];
     Rcpp::IntegerVector to = input ["to"];
     Rcpp::NumericVector d = input ["d"];
 
-    std::vector <MSTEdge> tree = mst (from, to, d);
+    std::vector <MSTEdge> tree = mst (from, to, d, nthreads);
 
     Rcpp::IntegerVector from_out (tree.size ());
     Rcpp::IntegerVector to_out (tree.size ());
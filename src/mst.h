@@ -9,6 +9,24 @@ struct MSTEdge {
     bool operator<(const MSTEdge& rhs) const { return dist < rhs.dist; }
 };
 
+/* Minimum spanning trees (or forests, for disconnected graphs) are calculated
+ * with Kruskal's algorithm on a single thread, or with Boruvka's algorithm on
+ * multiple threads. Both break ties between equal distances by the order of
+ * the input edges, and return edges in the same order, so that results are
+ * identical for any number of threads.
+ */
+
 std::vector <MSTEdge> mst (Rcpp::IntegerVector from,
         Rcpp::IntegerVector to,
-        Rcpp::NumericVector d);
+        Rcpp::NumericVector d,
+        const int nthreads = 1);
+
+// Equivalent version which makes no calls to the R API. Vertex numbers must be
+// non-negative.
+std::vector <MSTEdge> mst (std::vector <MSTEdge> edges,
+        const int nthreads = 1);
+
+// Boruvka's algorithm, with the cheapest edge from each component found in
+// parallel. Makes no calls to the R API.
+std::vector <MSTEdge> mst_boruvka (const std::vector <MSTEdge> &edges,
+        const int nthreads);
@@ -0,0 +1,127 @@
+#pragma once
+
+// Compile-time policies used to resolve the `shortest` flag and the
+// `precision` of stored distances. All engines are templated on a distance
+// type, T, and on one of the two comparison policies defined here, so that
+// the choice between shortest (distances) and longest (covariances) is made
+// once at the R/C++ interface, and not in every inner loop.
+
+#include <limits>
+#include <string>
+#include <utility> // std::forward
+
+// Generic equivalent of INFINITE_FLOAT, INFINITE_DOUBLE, and INFINITE_INT for
+// engines templated on distance types
+template <typename T>
+constexpr T infinite_value () {
+    return std::numeric_limits <T>::max ();
+}
+
+namespace policy {
+
+struct Shortest {
+    static constexpr bool shortest = true;
+
+    // Is `a` a stronger connection than `b`?
+    template <typename T>
+    static bool better (const T a, const T b) {
+        return a < b;
+    }
+
+    // Initial value which any observed distance will improve upon.
+    template <typename T>
+    static T worst () {
+        return infinite_value <T> ();
+    }
+};
+
+struct Longest {
+    static constexpr bool shortest = false;
+
+    template <typename T>
+    static bool better (const T a, const T b) {
+        return a > b;
+    }
+
+    template <typename T>
+    static T worst () {
+        return -infinite_value <T> ();
+    }
+};
+
+// Integer type used to store ranks of distances, for precision "rank".
+typedef int rank_t;
+
+// Type in which distances are passed to engines which store them as T: ranks
+// for precision "rank", and original values for all other precisions.
+template <typename T>
+struct Input {
+    typedef double type;
+};
+
+template <>
+struct Input <rank_t> {
+    typedef rank_t type;
+};
+
+// Distances as both original values and, for precision "rank", ranks, from
+// which `get` selects the form expected by engines storing distances as T.
+// This allows the same arguments to be passed to all instantiations by
+// `dispatch_order`.
+struct Dists {
+    const double *values = nullptr;
+    const rank_t *ranks = nullptr;
+
+    template <typename T>
+    const typename Input <T>::type *get () const {
+        return values;
+    }
+};
+
+template <>
+inline const rank_t *Dists::get <rank_t> () const {
+    return ranks;
+}
+
+// Dispatch a run-time (precision, shortest) pair to the matching template
+// instantiation of `F::run <T, Cmp>`, where F is a struct with a static
+// templated `run` function. All precisions other than "single" are stored as
+// double, including "rank", which only applies to `dispatch_order`.
+template <typename F, typename... Args>
+auto dispatch (const std::string &precision, const bool shortest,
+        Args&&... args) -> decltype (F::template run <double, Shortest> (
+                std::forward <Args> (args)...)) {
+    if (precision == "single") {
+        if (shortest) {
+            return F::template run <float, Shortest> (
+                    std::forward <Args> (args)...);
+        }
+        return F::template run <float, Longest> (std::forward <Args> (args)...);
+    }
+    if (shortest) {
+        return F::template run <double, Shortest> (
+                std::forward <Args> (args)...);
+    }
+    return F::template run <double, Longest> (std::forward <Args> (args)...);
+}
+
+// Equivalent of `dispatch` for engines which depend only on the order of
+// distances, and not on their values, for which precision "rank" resolves to
+// integer ranks. Distances are passed to such engines as `Dists`, which must
+// hold ranks for precision "rank".
+template <typename F, typename... Args>
+auto dispatch_order (const std::string &precision, const bool shortest,
+        Args&&... args) -> decltype (F::template run <double, Shortest> (
+                std::forward <Args> (args)...)) {
+    if (precision == "rank") {
+        if (shortest) {
+            return F::template run <rank_t, Shortest> (
+                    std::forward <Args> (args)...);
+        }
+        return F::template run <rank_t, Longest> (
+                std::forward <Args> (args)...);
+    }
+    return dispatch <F> (precision, shortest, std::forward <Args> (args)...);
+}
+
+} // end namespace policy
@@ -0,0 +1,168 @@
+#include "common.h"
+#include "radix-sort.h"
+#include "policies.h"
+#include "threads.h"
+
+#include <numeric> // std::iota
+
+namespace {
+
+constexpr size_t NBUCKETS = 256;
+
+// Indices are stored as I, which is uint32_t wherever possible, to reduce
+// memory use.
+template <typename I>
+std::vector <size_t> lsd_order (std::vector <uint64_t> &keys,
+        const int nthreads) {
+
+    const size_t n = keys.size ();
+    std::vector <I> index (n);
+    std::iota (index.begin (), index.end (), static_cast <I> (0));
+    std::vector <uint64_t> keys_tmp (n);
+    std::vector <I> index_tmp (n);
+
+    const size_t nt = threads::num_threads (nthreads,
+            std::max (n / radix_sort::MIN_CHUNK, static_cast <size_t> (1))),
+          chunk = (n + nt - 1) / nt;
+    // Counts of each byte for each thread, later converted to offsets
+    std::vector <size_t> counts (nt * NBUCKETS);
+
+    for (unsigned int pass = 0; pass < 8; pass++) {
+        const unsigned int shift = 8 * pass;
+
+        threads::parallel_for (nt, static_cast <int> (nt),
+                [&] (const size_t begin, const size_t end) {
+                    for (size_t t = begin; t < end; t++) {
+                        size_t *ct = counts.data () + t * NBUCKETS;
+                        std::fill (ct, ct + NBUCKETS, 0);
+                        const size_t i1 = std::min (n, (t + 1) * chunk);
+                        for (size_t i = t * chunk; i < i1; i++) {
+                            ct [(keys [i] >> shift) & 0xFF]++;
+                        }
+                    }
+                });
+
+        // Skip passes in which all keys have the same byte
+        bool skip = false;
+        for (size_t b = 0; b < NBUCKETS && !skip; b++) {
+            size_t total = 0;
+            for (size_t t = 0; t < nt; t++) {
+                total += counts [t * NBUCKETS + b];
+            }
+            skip = total == n;
+        }
+        if (skip) {
+            continue;
+        }
+
+        size_t offset = 0;
+        for (size_t b = 0; b < NBUCKETS; b++) {
+            for (size_t t = 0; t < nt; t++) {
+                const size_t count = counts [t * NBUCKETS + b];
+                counts [t * NBUCKETS + b] = offset;
+                offset += count;
+            }
+        }
+
+        threads::parallel_for (nt, static_cast <int> (nt),
+                [&] (const size_t begin, const size_t end) {
+                    for (size_t t = begin; t < end; t++) {
+                        size_t *ct = counts.data () + t * NBUCKETS;
+                        const size_t i1 = std::min (n, (t + 1) * chunk);
+                        for (size_t i = t * chunk; i < i1; i++) {
+                            const size_t pos =
+                                ct [(keys [i] >> shift) & 0xFF]++;
+                            keys_tmp [pos] = keys [i];
+                            index_tmp [pos] = index [i];
+                        }
+                    }
+                });
+
+        keys.swap (keys_tmp);
+        index.swap (index_tmp);
+    }
+
+    return std::vector <size_t> (index.begin (), index.end ());
+}
+
+} // end anonymous namespace
+
+std::vector <size_t> radix_sort::order (const double *x, const size_t n,
+        const bool ascending, const int nthreads) {
+
+    std::vector <uint64_t> keys (n);
+    for (size_t i = 0; i < n; i++) {
+        keys [i] = radix_sort::key (x [i], ascending);
+    }
+
+    if (n < radix_sort::MIN_RADIX) {
+        std::vector <size_t> index (n);
+        std::iota (index.begin (), index.end (), 0);
+        std::stable_sort (index.begin (), index.end (),
+                [&keys] (const size_t a, const size_t b) {
+                    return keys [a] < keys [b]; });
+        return index;
+    }
+
+    if (n <= std::numeric_limits <uint32_t>::max ()) {
+        return lsd_order <uint32_t> (keys, nthreads);
+    }
+    return lsd_order <size_t> (keys, nthreads);
+}
+
+std::vector <policy::rank_t> radix_sort::ranks (const double *x,
+        const size_t n, const bool ascending, const int nthreads) {
+
+    // Ranks must also compare as stronger than policy::Shortest::worst.
+    if (n >= static_cast <size_t> (
+                std::numeric_limits <policy::rank_t>::max ())) {
+        Rcpp::stop ("Too many distances to be stored as ranks");
+    }
+    for (size_t i = 0; i < n; i++) {
+        if (!std::isfinite (x [i])) {
+            Rcpp::stop ("Distances can only be ranked if all are finite");
+        }
+    }
+
+    const std::vector <size_t> index = radix_sort::order (x, n, ascending,
+            nthreads);
+
+    std::vector <policy::rank_t> res (n);
+    for (size_t r = 0; r < n; r++) {
+        res [index [r]] = static_cast <policy::rank_t> (ascending ?
+                r : n - 1 - r);
+    }
+
+    return res;
+}
+
+//' rcpp_radix_order
+//'
+//' Stable order of a vector of doubles, with NA values last.
+//'
+//' @param x Vector of values to be sorted
+//' @param decreasing If `TRUE`, sort in decreasing order
+//' @param nthreads Number of threads, with values <= 0 using all available
+//'
+//' @return 1-indexed permutation, equivalent to `order (x, decreasing)`.
+//' @noRd
+// [[Rcpp::export]]
+Rcpp::IntegerVector rcpp_radix_order (
+        const Rcpp::NumericVector x,
+        const bool decreasing,
+        const int nthreads) {
+
+    if (x.size () > std::numeric_limits <int>::max ()) {
+        Rcpp::stop ("Vectors of more than 2^31 - 1 values can not be sorted");
+    }
+
+    const std::vector <size_t> index = radix_sort::order (x.begin (),
+            static_cast <size_t> (x.size ()), !decreasing, nthreads);
+
+    Rcpp::IntegerVector res (static_cast <R_xlen_t> (index.size ()));
+    for (size_t i = 0; i < index.size (); i++) {
+        res [static_cast <R_xlen_t> (i)] = static_cast <int> (index [i]) + 1;
+    }
+
+    return res;
+}
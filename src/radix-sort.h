@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cmath> // std::isnan
+#include <cstdint>
+#include <cstring> // std::memcpy
+#include <limits>
+#include <vector>
+
+#include <Rcpp.h>
+
+#include "policies.h"
+
+// --------- PARALLEL RADIX SORT OF DISTANCES ----------------
+
+/* Stable least-significant-digit radix sort of double-precision keys, which
+ * returns a permutation rather than sorting in place. Each double is mapped
+ * onto an unsigned 64-bit key with the same order, by flipping all bits of
+ * negative values, and only the sign bit of positive values. Descending order
+ * is then simply the bitwise complement of these keys. Keys are sorted in
+ * eight passes of one byte each, with passes skipped wherever all keys share
+ * the same byte, as is typically the case for the highest bytes of distances.
+ *
+ * Each pass is parallelised by dividing keys into one contiguous chunk per
+ * thread. Each thread counts the bytes in its own chunk, and the counts are
+ * then combined in order of (byte, thread), so that each thread scatters its
+ * chunk into disjoint output positions, and the sort remains stable.
+ *
+ * Sorting is stable, and NaN values are always sorted last, so that results
+ * are identical to those of R's `order` and `dplyr::arrange`.
+ */
+
+namespace radix_sort {
+
+// Below this size, keys are sorted with std::stable_sort
+constexpr size_t MIN_RADIX = 1024;
+// Minimal number of keys for each thread
+constexpr size_t MIN_CHUNK = 65536;
+
+inline uint64_t key (double x, const bool ascending) {
+    if (std::isnan (x)) {
+        return std::numeric_limits <uint64_t>::max ();
+    }
+    if (x == 0.0) {
+        x = 0.0; // so that -0 and +0 are equal
+    }
+    uint64_t u;
+    std::memcpy (&u, &x, sizeof (u));
+    const uint64_t sign = static_cast <uint64_t> (1) << 63;
+    u = (u & sign) ? ~u : (u | sign);
+    return ascending ? u : ~u;
+}
+
+// Stable permutation which sorts the `n` values of `x`.
+std::vector <size_t> order (const double *x, const size_t n,
+        const bool ascending, const int nthreads = 1);
+
+// Distinct ranks of the `n` values of `x`, numbered from 0 in order of
+// increasing value. Ties are broken by position, with earlier values ranked
+// lower if `ascending`, and higher otherwise, so that earlier values always
+// compare as stronger under the comparison policy matching `ascending`. All
+// values must be finite.
+std::vector <policy::rank_t> ranks (const double *x, const size_t n,
+        const bool ascending, const int nthreads = 1);
+
+// Stably sort a vector or deque of objects by the values returned by `value`.
+template <typename C, typename F>
+void sort_by (C &v, F value, const bool ascending, const int nthreads = 1) {
+    std::vector <double> x (v.size ());
+    for (size_t i = 0; i < v.size (); i++) {
+        x [i] = static_cast <double> (value (v [i]));
+    }
+    const std::vector <size_t> index = radix_sort::order (x.data (), x.size (),
+            ascending, nthreads);
+
+    C res;
+    for (auto i: index) {
+        res.push_back (v [i]);
+    }
+    v.swap (res);
+}
+
+} // end namespace radix_sort
+
+Rcpp::IntegerVector rcpp_radix_order (
+        const Rcpp::NumericVector x,
+        const bool decreasing,
+        const int nthreads);
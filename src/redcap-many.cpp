@@ -0,0 +1,312 @@
+#include "common.h"
+#include "redcap-many.h"
+#include "slk.h"
+#include "alk.h"
+#include "clk.h"
+#include "cuttree.h"
+#include "mst.h"
+#include "kdtree.h"
+#include "threads.h"
+
+#include <numeric> // std::iota
+
+std::vector <double> redcap_many::spatial_dists (const Problem &prob) {
+    const size_t n = prob.n;
+    std::vector <double> dxy (n * n, 0.0);
+    for (size_t j = 0; j < n; j++) {
+        for (size_t i = j + 1; i < n; i++) {
+            double s = 0.0;
+            for (size_t k = 0; k < prob.p; k++) {
+                const double dk = prob.xy [i + k * n] - prob.xy [j + k * n];
+                s += dk * dk;
+            }
+            dxy [i + j * n] = dxy [j + i * n] = std::sqrt (s);
+        }
+    }
+    return dxy;
+}
+
+void redcap_many::sort_edges (Edges &edges, const bool shortest) {
+    std::vector <size_t> index (edges.d.size ());
+    std::iota (index.begin (), index.end (), 0);
+    const std::vector <double> &d = edges.d;
+    if (shortest) {
+        std::stable_sort (index.begin (), index.end (),
+                [&d] (const size_t a, const size_t b) { return d [a] < d [b]; });
+    } else {
+        std::stable_sort (index.begin (), index.end (),
+                [&d] (const size_t a, const size_t b) { return d [a] > d [b]; });
+    }
+
+    Edges res;
+    res.from.reserve (index.size ());
+    res.to.reserve (index.size ());
+    res.d.reserve (index.size ());
+    for (auto i: index) {
+        res.from.push_back (edges.from [i]);
+        res.to.push_back (edges.to [i]);
+        res.d.push_back (edges.d [i]);
+    }
+    edges = std::move (res);
+}
+
+redcap_many::Edges redcap_many::edges_nn (const Problem &prob,
+        const int nnbs, const bool shortest) {
+
+    const size_t n = prob.n;
+    const kdtree::Tree tree (prob.xy, n, prob.p);
+
+    // Nearest neighbours, including self-edges which are then removed
+    const size_t nn = static_cast <size_t> (nnbs) + 1;
+    const std::vector <size_t> nbs = shortest ?
+        tree.knn <policy::Shortest> (nn, 1) :
+        tree.knn <policy::Longest> (nn, 1);
+    Edges edges;
+    for (size_t j = 0; j < n; j++) {
+        for (size_t k = 0; k < nn; k++) {
+            const size_t i = nbs [j * nn + k];
+            if (i != j && i != kdtree::NONE) {
+                edges.from.push_back (static_cast <int> (j) + 1);
+                edges.to.push_back (static_cast <int> (i) + 1);
+            }
+        }
+    }
+
+    // Minimal spanning tree of spatial distances, to ensure that all edges form
+    // a single component, appended in both directions.
+    const std::vector <kdtree::Edge> mst_edges = tree.mst (1);
+    for (auto e: mst_edges) {
+        edges.from.push_back (static_cast <int> (e.from) + 1);
+        edges.to.push_back (static_cast <int> (e.to) + 1);
+    }
+    for (auto e: mst_edges) {
+        edges.from.push_back (static_cast <int> (e.to) + 1);
+        edges.to.push_back (static_cast <int> (e.from) + 1);
+    }
+
+    // Remove duplicates, keeping the first of each
+    std::unordered_set <size_t> seen;
+    seen.reserve (edges.from.size ());
+    Edges res;
+    for (size_t i = 0; i < edges.from.size (); i++) {
+        const size_t f = static_cast <size_t> (edges.from [i] - 1),
+                     t = static_cast <size_t> (edges.to [i] - 1);
+        if (seen.insert (f + t * n).second) {
+            res.from.push_back (edges.from [i]);
+            res.to.push_back (edges.to [i]);
+            res.d.push_back (tree.dist (f, t));
+        }
+    }
+
+    redcap_many::sort_edges (res, shortest);
+    return res;
+}
+
+redcap_many::Edges redcap_many::edges_all (const std::vector <double> &dxy,
+        const size_t n, const bool shortest) {
+    Edges edges;
+    edges.from.resize (n * n);
+    edges.to.resize (n * n);
+    edges.d = dxy;
+    for (size_t k = 0; k < n * n; k++) {
+        edges.from [k] = static_cast <int> (k % n) + 1;
+        edges.to [k] = static_cast <int> (k / n) + 1;
+    }
+    redcap_many::sort_edges (edges, shortest);
+    return edges;
+}
+
+template <typename T, typename Cmp>
+redcap_many::Result redcap_many::redcap (const Problem &prob,
+        const Pars &pars, budget::Budget &budget) {
+
+    const size_t n = prob.n;
+    const Edges enn = redcap_many::edges_nn (prob, pars.nnbs, pars.shortest);
+    const utils::IndexView from (enn.from, 1), to (enn.to, 1);
+
+    Result res;
+    Edges &tree = res.tree;
+
+    if (!pars.full_order) {
+        std::vector <MSTEdge> edges (enn.from.size ());
+        for (size_t i = 0; i < edges.size (); i++) {
+            edges [i].from = enn.from [i];
+            edges [i].to = enn.to [i];
+            edges [i].dist = enn.d [i];
+        }
+        std::vector <MSTEdge> mst_edges = mst (edges);
+        std::sort (mst_edges.begin (), mst_edges.end (),
+                [] (const MSTEdge &a, const MSTEdge &b) {
+                    return a.from < b.from ||
+                        (a.from == b.from && a.to < b.to); });
+        for (auto e: mst_edges) {
+            tree.from.push_back (e.from);
+            tree.to.push_back (e.to);
+        }
+    } else {
+        std::vector <index_t> index;
+        if (pars.linkage == Linkage::average) {
+            index = alk::alk_tree <T, Cmp> (from, to, enn.d.data (),
+                    budget, true, true);
+        } else {
+            // Only full-order single and complete linkage need all pairwise
+            // distances.
+            const std::vector <double> dxy =
+                redcap_many::spatial_dists (prob);
+            const Edges eall = redcap_many::edges_all (dxy, n, pars.shortest);
+            const utils::IndexView from_full (eall.from, 1),
+                  to_full (eall.to, 1);
+            if (pars.linkage == Linkage::single) {
+                index = slk::slk_tree <T, Cmp> (from_full, to_full, from, to,
+                        enn.d.data (), budget, true, true);
+            } else {
+                index = clk::clk_tree <T, Cmp> (from_full, to_full,
+                        eall.d.data (), from, to, enn.d.data (), budget, true,
+                        true);
+            }
+        }
+        for (auto i: index) {
+            tree.from.push_back (enn.from [i]);
+            tree.to.push_back (enn.to [i]);
+        }
+    }
+
+    // Replace spatial distances with those from `dmat`, and cut the tree:
+    tree.d.resize (tree.from.size ());
+    for (size_t i = 0; i < tree.d.size (); i++) {
+        const size_t f = static_cast <size_t> (tree.from [i] - 1),
+                     t = static_cast <size_t> (tree.to [i] - 1);
+        tree.d [i] = prob.dmat [f + t * n];
+    }
+    const utils::IndexView tree_from (tree.from, 1), tree_to (tree.to, 1);
+    cuttree::Limits limits;
+    limits.min_nodes = pars.min_size;
+    res.cluster = cuttree::cut_tree <T, Cmp> (tree_from, tree_to,
+            tree.d.data (), prob.ncl, limits, budget, true, true);
+    res.partial = budget.expired ();
+    for (auto &c: res.cluster) {
+        if (c != NA_INTEGER) {
+            c++;
+        }
+    }
+
+    return res;
+}
+
+template <typename T, typename Cmp>
+std::vector <redcap_many::Result> redcap_many::RedcapMany::run (
+        const std::vector <Problem> &problems,
+        const Pars &pars,
+        const budget::Budget &budget,
+        const int nthreads) {
+
+    const size_t n = problems.size ();
+    std::vector <Result> res (n);
+    threads::Errors errors (n);
+
+    threads::parallel_for_each (n, nthreads, [&] (const size_t i) {
+                errors.run (i, [&] () {
+                    budget::Budget prob_budget = budget.threaded ();
+                    res [i] = redcap_many::redcap <T, Cmp> (problems [i],
+                            pars, prob_budget);
+                });
+            });
+
+    errors.stop ("Failed to solve problem ");
+
+    return res;
+}
+
+//' rcpp_redcap_many
+//'
+//' Run the full redcap pipeline for each of a list of problems.
+//'
+//' @param problems List of problems, each of which is a list of `xy`, an (n x
+//' p) numeric matrix of coordinates, `dmat`, an (n x n) numeric matrix, and
+//' `ncl`, the desired number of clusters.
+//' @param min_size Minimal number of nodes in each cluster
+//' @param time_budget Maximal time in seconds for all problems together, with
+//' `Inf` for no limit
+//' @param nthreads Number of threads, with values <= 0 using all available
+//'
+//' @return List of trees, one for each problem, each with columns of "from",
+//' "to", "d", and "cluster", and a "partial" attribute which is `TRUE` if the
+//' time budget expired before that problem was solved.
+//' @noRd
+// [[Rcpp::export]]
+Rcpp::List rcpp_redcap_many (
+        const Rcpp::List problems,
+        const bool full_order,
+        const std::string linkage,
+        const bool shortest,
+        const int nnbs,
+        const int min_size,
+        const std::string precision,
+        const double time_budget,
+        const int nthreads) {
+    const budget::Budget budget (time_budget);
+
+    redcap_many::Pars pars;
+    pars.full_order = full_order;
+    pars.shortest = shortest;
+    pars.nnbs = nnbs;
+    pars.min_size = min_size;
+    if (linkage == "single") {
+        pars.linkage = redcap_many::Linkage::single;
+    } else if (linkage == "average") {
+        pars.linkage = redcap_many::Linkage::average;
+    } else if (linkage == "complete") {
+        pars.linkage = redcap_many::Linkage::complete;
+    } else {
+        Rcpp::stop ("linkage must be one of (single, average, complete)");
+    }
+    if (nnbs <= 0) {
+        Rcpp::stop ("nnbs must be positive");
+    }
+    if (min_size < 2) {
+        Rcpp::stop ("min_size must be at least 2");
+    }
+
+    // All inputs are validated here, so that worker threads only ever read
+    // from the matrices.
+    const size_t nprobs = static_cast <size_t> (problems.size ());
+    std::vector <redcap_many::Problem> probs (nprobs);
+    for (size_t i = 0; i < nprobs; i++) {
+        const Rcpp::List p = problems [i];
+        Rcpp::NumericMatrix xy = p ["xy"];
+        Rcpp::NumericMatrix dmat = p ["dmat"];
+        const int n = xy.nrow ();
+        if (n <= nnbs) {
+            Rcpp::stop ("Problem " + std::to_string (i + 1) +
+                    " has fewer points than nnbs + 1");
+        }
+        if (dmat.nrow () != n || dmat.ncol () != n) {
+            Rcpp::stop ("Problem " + std::to_string (i + 1) +
+                    " has dmat of wrong dimensions");
+        }
+        probs [i].xy = xy.begin ();
+        probs [i].dmat = dmat.begin ();
+        probs [i].n = static_cast <size_t> (n);
+        probs [i].p = static_cast <size_t> (xy.ncol ());
+        probs [i].ncl = Rcpp::as <int> (p ["ncl"]);
+    }
+
+    std::vector <redcap_many::Result> res =
+        policy::dispatch <redcap_many::RedcapMany> (precision, shortest,
+                probs, pars, budget, nthreads);
+
+    Rcpp::List out (nprobs);
+    for (size_t i = 0; i < nprobs; i++) {
+        const redcap_many::Result &r = res [i];
+        Rcpp::DataFrame tree = Rcpp::DataFrame::create (
+                Rcpp::Named ("from") = r.tree.from,
+                Rcpp::Named ("to") = r.tree.to,
+                Rcpp::Named ("d") = r.tree.d,
+                Rcpp::Named ("cluster") = r.cluster,
+                Rcpp::_["stringsAsFactors"] = false);
+        tree.attr ("partial") = r.partial;
+        out [i] = tree;
+    }
+
+    return out;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "utils.h"
+#include "policies.h"
+#include "budget.h"
+
+// --------- MANY SMALL REDCAP PROBLEMS ----------------
+
+/* Native version of the full scl_redcap pipeline, from nearest-neighbour
+ * edges, through spanning tree construction, to tree cutting, for many small
+ * and independent problems. Each problem is run entirely in C++ on a pool of
+ * worker threads, so no part of the pipeline may call the R API. Each step
+ * mirrors the equivalent R function, with nearest-neighbour edges and their
+ * spanning tree taken from the same kdtree::Tree code, and so gives identical
+ * results. All vertex numbers are 1-indexed, as in R.
+ */
+
+namespace redcap_many {
+
+enum class Linkage { single, average, complete };
+
+// Pointers into R memory, which are only ever read from worker threads.
+struct Problem {
+    const double *xy; // (n x p) coordinates, column-major
+    const double *dmat; // (n x n) dissimilarities, column-major
+    size_t n, p;
+    int ncl;
+};
+
+struct Pars {
+    bool full_order, shortest;
+    Linkage linkage;
+    int nnbs, min_size;
+};
+
+struct Edges {
+    std::vector <int> from, to;
+    std::vector <double> d;
+};
+
+struct Result {
+    Edges tree;
+    std::vector <int> cluster; // 1-indexed, or NA_INTEGER
+    bool partial = false; // budget expired before the tree was fully cut
+};
+
+// Euclidean distances between all pairs of points, as for `stats::dist`, which
+// are only needed for full-order single and complete linkage.
+std::vector <double> spatial_dists (const Problem &prob);
+
+// Stable sort of edges by distance, as for `dplyr::arrange`.
+void sort_edges (Edges &edges, const bool shortest);
+
+// As for R's `scl_edges_nn`, using the same kdtree::Tree neighbours and
+// minimal spanning tree.
+Edges edges_nn (const Problem &prob, const int nnbs, const bool shortest);
+
+// As for R's `scl_edges_all`.
+Edges edges_all (const std::vector <double> &dxy, const size_t n,
+        const bool shortest);
+
+// Both tree construction and cutting stop once `budget`, which must be a
+// `threaded` copy, expires, in which case the result is flagged as partial.
+template <typename T, typename Cmp>
+Result redcap (const Problem &prob, const Pars &pars, budget::Budget &budget);
+
+// Target for policy::dispatch. All problems share the deadline of `budget`.
+struct RedcapMany {
+    template <typename T, typename Cmp>
+    static std::vector <Result> run (const std::vector <Problem> &problems,
+            const Pars &pars, const budget::Budget &budget,
+            const int nthreads);
+};
+
+} // end namespace redcap_many
+
+Rcpp::List rcpp_redcap_many (
+        const Rcpp::List problems,
+        const bool full_order,
+        const std::string linkage,
+        const bool shortest,
+        const int nnbs,
+        const int min_size,
+        const std::string precision,
+        const double time_budget,
+        const int nthreads);
@@ -0,0 +1,256 @@
+#include "common.h"
+#include "scl-io.h"
+
+#include <cstring>
+
+namespace {
+
+scl_io::SectionType section_type (const SEXP x) {
+    switch (TYPEOF (x)) {
+        case INTSXP:
+            return scl_io::SECTION_INTEGER;
+        case REALSXP:
+            return scl_io::SECTION_DOUBLE;
+        case RAWSXP:
+            return scl_io::SECTION_RAW;
+        case LGLSXP:
+            return scl_io::SECTION_LOGICAL;
+        default:
+            Rcpp::stop ("sections must be integer, double, logical, or raw");
+    }
+}
+
+const void * section_data (const SEXP x) {
+    switch (TYPEOF (x)) {
+        case INTSXP:
+            return INTEGER (x);
+        case REALSXP:
+            return REAL (x);
+        case RAWSXP:
+            return RAW (x);
+        default:
+            return LOGICAL (x);
+    }
+}
+
+void * section_data (SEXP x, const uint32_t type) {
+    switch (type) {
+        case scl_io::SECTION_INTEGER:
+            return INTEGER (x);
+        case scl_io::SECTION_DOUBLE:
+            return REAL (x);
+        case scl_io::SECTION_RAW:
+            return RAW (x);
+        default:
+            return LOGICAL (x);
+    }
+}
+
+[[noreturn]] void truncated (const std::string &path) {
+    Rcpp::stop ("File [" + path + "] is truncated");
+}
+
+// Read the section table and names.
+void read_table (const scl_io::File &file, const std::string &path,
+        std::vector <scl_io::SectionEntry> &table,
+        std::vector <std::string> &names) {
+
+    const size_t nsections = table.size ();
+    if (nsections == 0) {
+        return;
+    }
+
+    if (std::fread (table.data (), sizeof (scl_io::SectionEntry), nsections,
+                file.f) != nsections) {
+        truncated (path);
+    }
+    for (size_t i = 0; i < nsections; i++) {
+        const scl_io::SectionEntry &e = table [i];
+        names [i].resize (e.name_len);
+        if (e.name_len > 0) {
+            scl_io::seek (file.f, e.name_offset, path);
+            if (std::fread (&names [i] [0], 1, e.name_len, file.f) !=
+                    e.name_len) {
+                truncated (path);
+            }
+        }
+    }
+}
+
+} // end anonymous namespace
+
+void scl_io::seek (FILE *f, const uint64_t pos, const std::string &path) {
+#ifdef _WIN32
+    const int res = _fseeki64 (f, static_cast <long long> (pos), SEEK_SET);
+#else
+    const int res = fseeko (f, static_cast <off_t> (pos), SEEK_SET);
+#endif
+    if (res != 0) {
+        Rcpp::stop ("Unable to seek in file [" + path + "]");
+    }
+}
+
+uint64_t scl_io::file_size (FILE *f, const std::string &path) {
+#ifdef _WIN32
+    const int res = _fseeki64 (f, 0, SEEK_END);
+    const long long size = res == 0 ? _ftelli64 (f) : -1;
+#else
+    const int res = fseeko (f, 0, SEEK_END);
+    const off_t size = res == 0 ? ftello (f) : -1;
+#endif
+    if (size < 0) {
+        Rcpp::stop ("Unable to determine size of file [" + path + "]");
+    }
+    scl_io::seek (f, 0, path);
+    return static_cast <uint64_t> (size);
+}
+
+//' rcpp_scl_write
+//'
+//' Write a named list of atomic vectors to a binary file.
+//'
+//' @param path Path to file
+//' @param sections Named list of integer, double, logical, or raw vectors
+//' @noRd
+// [[Rcpp::export]]
+void rcpp_scl_write (const std::string path, const Rcpp::List sections) {
+
+    const size_t nsections = static_cast <size_t> (sections.size ());
+    if (Rf_isNull (sections.attr ("names"))) {
+        Rcpp::stop ("sections must be named");
+    }
+    const std::vector <std::string> nms =
+        Rcpp::as <std::vector <std::string> > (sections.attr ("names"));
+
+    scl_io::Header header;
+    std::memcpy (header.magic, scl_io::FILE_MAGIC, sizeof (header.magic));
+    header.version = scl_io::FILE_VERSION;
+    header.byte_order = scl_io::BYTE_ORDER_MARK;
+    header.nsections = static_cast <uint32_t> (nsections);
+
+    std::vector <scl_io::SectionEntry> table (nsections);
+    uint64_t pos = sizeof (scl_io::Header) +
+        nsections * sizeof (scl_io::SectionEntry);
+    for (size_t i = 0; i < nsections; i++) {
+        scl_io::SectionEntry &e = table [i];
+        e.name_len = static_cast <uint32_t> (nms [i].size ());
+        e.name_offset = pos;
+        pos += e.name_len;
+    }
+    const uint64_t data_pos = pos;
+    for (size_t i = 0; i < nsections; i++) {
+        const SEXP x = sections [i];
+        scl_io::SectionEntry &e = table [i];
+        e.type = section_type (x);
+        e.length = static_cast <uint64_t> (Rf_xlength (x));
+        e.offset = scl_io::aligned (pos);
+        pos = e.offset + e.length * scl_io::element_size (e.type);
+    }
+
+    scl_io::File file (path, "wb");
+    if (file.f == nullptr) {
+        Rcpp::stop ("Unable to open file [" + path + "] for writing");
+    }
+
+    bool ok = std::fwrite (&header, sizeof (header), 1, file.f) == 1;
+    if (nsections > 0) {
+        ok = ok && std::fwrite (table.data (), sizeof (scl_io::SectionEntry),
+                nsections, file.f) == nsections;
+    }
+
+    for (size_t i = 0; i < nsections && ok; i++) {
+        const size_t len = static_cast <size_t> (table [i].name_len);
+        if (len > 0) {
+            ok = std::fwrite (nms [i].data (), 1, len, file.f) == len;
+        }
+    }
+
+    const char padding [scl_io::DATA_ALIGN] = {0};
+    pos = data_pos;
+    for (size_t i = 0; i < nsections && ok; i++) {
+        const scl_io::SectionEntry &e = table [i];
+        const size_t npad = static_cast <size_t> (e.offset - pos);
+        if (npad > 0) {
+            ok = std::fwrite (padding, 1, npad, file.f) == npad;
+        }
+        const size_t len = static_cast <size_t> (e.length),
+                     nbytes = len * scl_io::element_size (e.type);
+        if (len > 0) {
+            ok = ok && std::fwrite (section_data (sections [i]),
+                    scl_io::element_size (e.type), len, file.f) == len;
+        }
+        pos = e.offset + nbytes;
+    }
+
+    if (!ok) {
+        Rcpp::stop ("Unable to write to file [" + path + "]");
+    }
+}
+
+//' rcpp_scl_read
+//'
+//' Read a binary file written by `rcpp_scl_write`.
+//'
+//' @param path Path to file
+//'
+//' @return Named list of integer, double, logical, or raw vectors
+//' @noRd
+// [[Rcpp::export]]
+Rcpp::List rcpp_scl_read (const std::string path) {
+
+    scl_io::File file (path, "rb");
+    if (file.f == nullptr) {
+        Rcpp::stop ("Unable to open file [" + path + "]");
+    }
+
+    scl_io::Header header;
+    if (std::fread (&header, sizeof (header), 1, file.f) != 1 ||
+            std::memcmp (header.magic, scl_io::FILE_MAGIC,
+                sizeof (header.magic)) != 0) {
+        Rcpp::stop ("File [" + path + "] is not an scl file");
+    }
+    if (header.byte_order != scl_io::BYTE_ORDER_MARK) {
+        Rcpp::stop ("File [" + path + "] was written with a different " +
+                "byte order");
+    }
+    if (header.version != scl_io::FILE_VERSION) {
+        Rcpp::stop ("File [" + path + "] has format version " +
+                std::to_string (header.version) +
+                ", but this version of spatialcluster reads only version " +
+                std::to_string (scl_io::FILE_VERSION));
+    }
+
+    const size_t nsections = static_cast <size_t> (header.nsections);
+    std::vector <scl_io::SectionEntry> table (nsections);
+    std::vector <std::string> names (nsections);
+    read_table (file, path, table, names);
+
+    Rcpp::List res (nsections);
+    Rcpp::CharacterVector nms (nsections);
+    for (size_t i = 0; i < nsections; i++) {
+        const scl_io::SectionEntry &e = table [i];
+        if (e.type > scl_io::SECTION_LOGICAL) {
+            Rcpp::stop ("File [" + path + "] has unknown section type");
+        }
+        nms [i] = names [i];
+
+        const SEXPTYPE rtype = e.type == scl_io::SECTION_INTEGER ? INTSXP :
+            (e.type == scl_io::SECTION_DOUBLE ? REALSXP :
+             (e.type == scl_io::SECTION_RAW ? RAWSXP : LGLSXP));
+        const size_t len = static_cast <size_t> (e.length);
+        Rcpp::RObject x = Rf_allocVector (rtype,
+                static_cast <R_xlen_t> (len));
+        if (len > 0) {
+            scl_io::seek (file.f, e.offset, path);
+            if (std::fread (section_data (x, e.type),
+                        scl_io::element_size (e.type), len,
+                        file.f) != len) {
+                truncated (path);
+            }
+        }
+        res [i] = x;
+    }
+    res.attr ("names") = nms;
+
+    return res;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+
+// --------- BINARY STORAGE OF SCL OBJECTS ----------------
+
+/* `scl` objects are stored as a flat sequence of named sections, each of which
+ * is a single vector of integer, double, logical, or raw values. Raw sections
+ * hold R-serialized objects, and are used only for small components such as
+ * `pars`. The layout is:
+ *
+ * 1. A 16-byte header holding the four-byte magic "SCLB", followed by three
+ *    uint32 values: the format version, a byte-order mark, and the number of
+ *    sections.
+ * 2. A table of 32-byte entries, one per section, each holding the type and
+ *    length in bytes of the section name, the byte offset of the name, the
+ *    number of elements, and the byte offset of the data, with offsets from
+ *    the start of the file.
+ * 3. A string table holding all section names, without terminators, so that
+ *    names may be of any length.
+ * 4. The data of each section, starting on an 8-byte boundary.
+ *
+ * Sections are therefore aligned for direct memory-mapping, and are read with
+ * one sequential read each.
+ */
+
+namespace scl_io {
+
+constexpr char FILE_MAGIC [4] = {'S', 'C', 'L', 'B'};
+constexpr uint32_t FILE_VERSION = 1;
+constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+constexpr size_t DATA_ALIGN = 8;
+
+enum SectionType : uint32_t {
+    SECTION_INTEGER = 0,
+    SECTION_DOUBLE = 1,
+    SECTION_RAW = 2,
+    SECTION_LOGICAL = 3
+};
+
+struct Header {
+    char magic [4];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t nsections;
+};
+
+struct SectionEntry {
+    uint32_t type;
+    uint32_t name_len; // bytes
+    uint64_t name_offset; // bytes from start of file
+    uint64_t length; // number of elements
+    uint64_t offset; // bytes from start of file
+};
+
+static_assert (sizeof (Header) == 16, "scl_io::Header must be 16 bytes");
+static_assert (sizeof (SectionEntry) == 32,
+        "scl_io::SectionEntry must be 32 bytes");
+
+// File handle closed on destruction, so that Rcpp::stop can be called at any
+// point.
+struct File {
+    FILE *f = nullptr;
+
+    File (const std::string &path, const char *mode) {
+        f = std::fopen (path.c_str (), mode);
+    }
+
+    ~File () {
+        if (f != nullptr) {
+            std::fclose (f);
+        }
+    }
+};
+
+inline size_t element_size (const uint32_t type) {
+    return type == SECTION_DOUBLE ? sizeof (double) :
+        (type == SECTION_RAW ? sizeof (Rbyte) : sizeof (int));
+}
+
+inline uint64_t aligned (const uint64_t pos) {
+    return (pos + DATA_ALIGN - 1) / DATA_ALIGN * DATA_ALIGN;
+}
+
+// Move to byte `pos` from the start of `f`, with 64-bit offsets on all
+// platforms.
+void seek (FILE *f, const uint64_t pos, const std::string &path);
+
+// Size in bytes of `f`, which is left positioned at the start.
+uint64_t file_size (FILE *f, const std::string &path);
+
+} // end namespace scl_io
+
+void rcpp_scl_write (const std::string path, const Rcpp::List sections);
+
+Rcpp::List rcpp_scl_read (const std::string path);
@@ -0,0 +1,270 @@
+#include "common.h"
+#include "scl-update.h"
+#include "kdtree.h"
+
+//' rcpp_insert_points
+//'
+//' Connect new points to an existing tree.
+//'
+//' @param xy (n x 2) matrix of coordinates of existing points
+//' @param xy_new (m x 2) matrix of coordinates of new points
+//' @param dmat (m x n) or (m x (n + m)) matrix of dissimilarities from each new
+//' point to all existing points, and optionally to all new points.
+//' @param cluster Cluster numbers of the n existing points, with NA for points
+//' not in any cluster.
+//' @param nnbs Number of spatially nearest neighbours considered for each new
+//' point.
+//'
+//' @return List of `edges`, a `data.frame` of one new tree edge for each new
+//' point, and `cluster`, an integer vector of clusters of the new points.
+//' @noRd
+// [[Rcpp::export]]
+Rcpp::List rcpp_insert_points (
+        const Rcpp::NumericMatrix xy,
+        const Rcpp::NumericMatrix xy_new,
+        const Rcpp::NumericMatrix dmat,
+        const Rcpp::IntegerVector cluster,
+        const int nnbs,
+        const bool shortest) {
+
+    const size_t n = static_cast <size_t> (xy.nrow ()),
+          m = static_cast <size_t> (xy_new.nrow ()),
+          nc = static_cast <size_t> (dmat.ncol ());
+
+    if (xy.ncol () < 2 || xy_new.ncol () < 2) {
+        Rcpp::stop ("coordinates must have 2 columns");
+    }
+    if (static_cast <size_t> (cluster.size ()) != n) {
+        Rcpp::stop ("cluster must have one value for each existing point");
+    }
+    if (static_cast <size_t> (dmat.nrow ()) != m ||
+            (nc != n && nc != n + m)) {
+        Rcpp::stop ("dmat must have one row for each new point, and one "
+                "column for each existing point, or for each existing and "
+                "new point");
+    }
+    if (nnbs <= 0) {
+        Rcpp::stop ("nnbs must be positive");
+    }
+
+    // Coordinates of all existing and new points, in one k-d tree. Each new
+    // point is connected to one of the first (n + i) points, or, where `dmat`
+    // has no columns for new points, only to one of the first n points.
+    std::vector <double> xy_all (2 * (n + m));
+    for (size_t c = 0; c < 2; c++) {
+        for (size_t i = 0; i < n; i++) {
+            xy_all [i + c * (n + m)] = xy (i, c);
+        }
+        for (size_t i = 0; i < m; i++) {
+            xy_all [n + i + c * (n + m)] = xy_new (i, c);
+        }
+    }
+    for (auto v: xy_all) {
+        if (!std::isfinite (v)) {
+            Rcpp::stop ("Coordinates must all be finite");
+        }
+    }
+    const kdtree::Tree kd (xy_all.data (), n + m, 2);
+
+    std::vector <int> cl (n + m, NA_INTEGER);
+    for (size_t i = 0; i < n; i++) {
+        cl [i] = cluster [i];
+    }
+    const bool connect_new = nc == n + m;
+
+    Rcpp::IntegerVector from (m), to (m), cl_out (m);
+    Rcpp::NumericVector d (m);
+
+    for (size_t i = 0; i < m; i++) {
+        const size_t ncandidates = connect_new ? n + i : n;
+        if (ncandidates == 0) {
+            Rcpp::stop ("there are no points to connect to");
+        }
+        const size_t v = n + i;
+        const std::vector <kdtree::Neighbour> nbs = kd.nearest (v,
+                static_cast <size_t> (nnbs), ncandidates);
+
+        size_t best = nbs [0].i;
+        for (auto nb: nbs) {
+            if (scl_update::better (dmat (i, nb.i), dmat (i, best),
+                        shortest)) {
+                best = nb.i;
+            }
+        }
+        if (ISNAN (dmat (i, best))) {
+            Rcpp::stop ("new point " + std::to_string (i + 1) +
+                    " has no non-missing dissimilarities to its neighbours");
+        }
+
+        cl [v] = cl [best];
+
+        from [i] = static_cast <int> (v) + 1;
+        to [i] = static_cast <int> (best) + 1;
+        d [i] = dmat (i, best);
+        cl_out [i] = cl [v];
+    }
+
+    Rcpp::DataFrame edges = Rcpp::DataFrame::create (
+        Rcpp::Named ("from") = from,
+        Rcpp::Named ("to") = to,
+        Rcpp::Named ("d") = d,
+        Rcpp::Named ("cluster") = cl_out,
+        Rcpp::_["stringsAsFactors"] = false);
+
+    return Rcpp::List::create (
+        Rcpp::Named ("edges") = edges,
+        Rcpp::Named ("cluster") = cl_out);
+}
+
+//' rcpp_remove_points
+//'
+//' Remove points from an existing tree, reconnecting the remaining points.
+//'
+//' @param tree `data.frame` of tree edges, with columns of "from", "to", "d",
+//' and "cluster".
+//' @param remove Vertex numbers to be removed.
+//' @param n Total number of vertices.
+//'
+//' @return Modified version of `tree`, with vertices renumbered to remain
+//' contiguous.
+//' @noRd
+// [[Rcpp::export]]
+Rcpp::DataFrame rcpp_remove_points (
+        const Rcpp::DataFrame tree,
+        const Rcpp::IntegerVector remove,
+        const int n,
+        const bool shortest) {
+
+    const Rcpp::IntegerVector from_in = tree ["from"];
+    const Rcpp::IntegerVector to_in = tree ["to"];
+    const Rcpp::NumericVector d_in = tree ["d"];
+    const Rcpp::IntegerVector cl_in = tree ["cluster"];
+
+    const size_t nv = static_cast <size_t> (n) + 1;
+    std::vector <scl_update::Edge> edges;
+    edges.reserve (static_cast <size_t> (from_in.size ()));
+    std::vector <bool> removed (nv, false);
+    for (auto r: remove) {
+        if (r < 1 || r > n) {
+            Rcpp::stop ("points to remove must be between 1 and " +
+                    std::to_string (n));
+        }
+        removed [static_cast <size_t> (r)] = true;
+    }
+
+    // Indices into `edges` of all edges adjacent to each vertex
+    std::vector <std::vector <size_t> > adj (nv);
+    for (R_xlen_t i = 0; i < from_in.size (); i++) {
+        if (from_in [i] < 1 || from_in [i] > n ||
+                to_in [i] < 1 || to_in [i] > n) {
+            Rcpp::stop ("tree vertex numbers must be between 1 and " +
+                    std::to_string (n));
+        }
+        scl_update::Edge e;
+        e.from = from_in [i];
+        e.to = to_in [i];
+        e.d = d_in [i];
+        e.cluster = cl_in [i];
+        edges.push_back (e);
+        adj [static_cast <size_t> (e.from)].push_back (edges.size () - 1);
+        adj [static_cast <size_t> (e.to)].push_back (edges.size () - 1);
+    }
+    std::vector <bool> alive (edges.size (), true);
+
+    for (auto r: remove) {
+        const size_t v = static_cast <size_t> (r);
+
+        // Edges remaining on v, with the best one first
+        std::vector <size_t> ev;
+        for (auto i: adj [v]) {
+            if (alive [i]) {
+                ev.push_back (i);
+                alive [i] = false;
+            }
+        }
+        if (ev.size () < 2) {
+            continue;
+        }
+        std::stable_sort (ev.begin (), ev.end (),
+                [&edges, shortest] (const size_t a, const size_t b) {
+                    return scl_update::better (edges [a].d, edges [b].d,
+                            shortest); });
+
+        // The removed point lies in at most one cluster, so its edges form
+        // one group of edges within that cluster, and single between-cluster
+        // edges. Neighbours within the cluster are joined to the neighbour on
+        // its best edge, and each group is then joined to the best group by a
+        // single between-cluster edge. Because ev is sorted best-first, new
+        // edges take the distance of the weaker of the two edges they replace.
+        auto other = [r] (const scl_update::Edge &e) {
+            return e.from == r ? e.to : e.from;
+        };
+        auto add_edge = [&] (const int from, const int to, const double d,
+                const int cluster) {
+            scl_update::Edge e;
+            e.from = from;
+            e.to = to;
+            e.d = d;
+            e.cluster = cluster;
+            edges.push_back (e);
+            alive.push_back (true);
+            adj [static_cast <size_t> (from)].push_back (edges.size () - 1);
+            adj [static_cast <size_t> (to)].push_back (edges.size () - 1);
+        };
+
+        int hub_in = 0; // neighbour on the best within-cluster edge
+        for (auto i: ev) {
+            const scl_update::Edge ek = edges [i];
+            if (ek.cluster == NA_INTEGER) {
+                continue;
+            }
+            if (hub_in == 0) {
+                hub_in = other (ek);
+            } else {
+                add_edge (hub_in, other (ek), ek.d, ek.cluster);
+            }
+        }
+
+        const scl_update::Edge e0 = edges [ev [0]];
+        const int hub = e0.cluster == NA_INTEGER ? other (e0) : hub_in;
+        bool joined_in = e0.cluster != NA_INTEGER;
+        for (size_t k = 1; k < ev.size (); k++) {
+            const scl_update::Edge ek = edges [ev [k]];
+            if (ek.cluster != NA_INTEGER) {
+                if (!joined_in) {
+                    add_edge (hub, hub_in, ek.d, NA_INTEGER);
+                    joined_in = true;
+                }
+            } else {
+                add_edge (hub, other (ek), ek.d, NA_INTEGER);
+            }
+        }
+    }
+
+    // Renumber remaining vertices to be contiguous:
+    std::vector <int> new_id (nv, 0);
+    int count = 0;
+    for (size_t i = 1; i < nv; i++) {
+        if (!removed [i]) {
+            new_id [i] = ++count;
+        }
+    }
+
+    std::vector <int> from, to, cl;
+    std::vector <double> d;
+    for (size_t i = 0; i < edges.size (); i++) {
+        if (alive [i]) {
+            from.push_back (new_id [static_cast <size_t> (edges [i].from)]);
+            to.push_back (new_id [static_cast <size_t> (edges [i].to)]);
+            d.push_back (edges [i].d);
+            cl.push_back (edges [i].cluster);
+        }
+    }
+
+    return Rcpp::DataFrame::create (
+        Rcpp::Named ("from") = from,
+        Rcpp::Named ("to") = to,
+        Rcpp::Named ("d") = d,
+        Rcpp::Named ("cluster") = cl,
+        Rcpp::_["stringsAsFactors"] = false);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+// --------- INCREMENTAL UPDATES OF CLUSTER TREES ----------------
+
+/* Insertion and removal of points from existing cluster trees, changing only
+ * the edges adjacent to each point, and leaving all other edges and the
+ * clusters of all other points unchanged.
+ *
+ * Insertion connects each new point to the one of its `nnbs` spatially nearest
+ * neighbours, found from a k-d tree of all existing and new points, with the
+ * strongest relationship in `dmat`, equivalent to a
+ * single-linkage step restricted to that neighbourhood, and the new point then
+ * takes the cluster of that neighbour. Removal reconnects the tree neighbours
+ * of each removed point, with neighbours joined by edges within the cluster of
+ * that point reconnected to the one joined by the strongest such edge, and all
+ * remaining groups of neighbours joined to the strongest group by single
+ * between-cluster edges. New edges take the weaker of the two edge distances
+ * which previously joined them via the removed point, so that spanning tree
+ * paths retain the same bottleneck distances, and every remaining point
+ * retains its cluster.
+ */
+
+namespace scl_update {
+
+// Tree edges, with 1-indexed vertex numbers and clusters, as in R.
+struct Edge {
+    int from, to;
+    double d;
+    int cluster;
+};
+
+// Is distance `a` better than `b`, with NA values always worse?
+inline bool better (const double a, const double b, const bool shortest) {
+    if (ISNAN (a)) {
+        return false;
+    }
+    if (ISNAN (b)) {
+        return true;
+    }
+    return shortest ? a < b : a > b;
+}
+
+} // end namespace scl_update
+
+Rcpp::List rcpp_insert_points (
+        const Rcpp::NumericMatrix xy,
+        const Rcpp::NumericMatrix xy_new,
+        const Rcpp::NumericMatrix dmat,
+        const Rcpp::IntegerVector cluster,
+        const int nnbs,
+        const bool shortest);
+
+Rcpp::DataFrame rcpp_remove_points (
+        const Rcpp::DataFrame tree,
+        const Rcpp::IntegerVector remove,
+        const int n,
+        const bool shortest);
@@ -1,105 +1,229 @@
 #include "common.h"
-#include "utils.h"
 #include "slk.h"
-#include <algorithm>
+#include "radix-sort.h"
 
 // --------- SINGLE LINKAGE CLUSTER ----------------
 
+template <typename T>
+bool slk::SLKLinkage <T>::next (agglomerate::AggDat <T> &dat,
+        agglomerate::MergePair &pr) {
+    /* The contiguity matrix retains is shape, so is always indexed by the
+     * (from, to) vectors. Merging clusters simply switches additional entries
+     * from  0 to 1.
+     */
+    auto joins = [&] (const edge_sort::Edge &e, int &cfrom, int &cto) {
+        index_t ifrom = utils::vert_index (dat.vert2index, e.from),
+                ito = utils::vert_index (dat.vert2index, e.to);
+        cfrom = dat.clusters.cluster (ifrom);
+        cto = dat.clusters.cluster (ito);
+        return cfrom != cto &&
+                dat.contig_mat (static_cast <arma::uword> (ifrom),
+                                static_cast <arma::uword> (ito)) > 0;
+    };
+
+    // Pending edges all precede the current position, so are checked first,
+    // with edges now within a single cluster removed.
+    bool found = false;
+    size_t npending = 0;
+    int cfrom, cto;
+    for (auto e: pending) {
+        if (!found && joins (e, cfrom, cto)) {
+            pr.cfrom = cfrom;
+            pr.cto = cto;
+            found = true;
+        } else if (found || cfrom != cto) {
+            pending [npending++] = e;
+        }
+    }
+    pending.resize (npending);
+    if (found) {
+        return true;
+    }
+
+    if (overflow != slk::NONE) {
+        edges_full.seek (overflow);
+        overflow = slk::NONE;
+    }
+    edge_sort::Edge e;
+    while (edges_full.next (e)) {
+        if (joins (e, cfrom, cto)) {
+            pr.cfrom = cfrom;
+            pr.cto = cto;
+            return true;
+        }
+        if (cfrom == cto || overflow != slk::NONE) {
+            continue;
+        }
+        if (pending.size () < slk::MAX_PENDING) {
+            pending.push_back (e);
+        } else {
+            overflow = edges_full.position () - 1;
+        }
+    }
+    return false;
+}
+
+// Single linkage has no state beyond that of the core
+template <typename T>
+void slk::SLKLinkage <T>::update (agglomerate::AggDat <T> &,
+        const agglomerate::MergePair &) {
+}
+
+// The main SLK routine, templated on the storage type of the distance matrix,
+// and on the comparison policy.
+template <typename T, typename Cmp>
+std::vector <index_t> slk::slk_tree_edges (
+        edge_sort::EdgeSource &edges_full,
+        const utils::IndexView &from,
+        const utils::IndexView &to,
+        const typename policy::Input <T>::type *d,
+        budget::Budget &budget,
+        const bool quiet,
+        const bool threaded) {
+    agglomerate::AggDat <T> dat;
+    agglomerate::init <T, Cmp> (dat, from, to, d);
+
+    slk::SLKLinkage <T> linkage (edges_full);
+
+    return agglomerate::run <T, Cmp> (dat, linkage, from, to, budget, quiet,
+            threaded);
+}
+
+// Version for full edge lists held in memory. Distances are not needed, as
+// single linkage depends only on the order of the full edge list.
+template <typename T, typename Cmp>
+std::vector <index_t> slk::slk_tree (
+        const utils::IndexView &from_full,
+        const utils::IndexView &to_full,
+        const utils::IndexView &from,
+        const utils::IndexView &to,
+        const typename policy::Input <T>::type *d,
+        budget::Budget &budget,
+        const bool quiet,
+        const bool threaded) {
+    edge_sort::EdgeSource edges_full (from_full, to_full);
+    return slk::slk_tree_edges <T, Cmp> (edges_full, from, to, d, budget,
+            quiet, threaded);
+}
+
+template std::vector <index_t> slk::slk_tree <float, policy::Shortest> (
+        const utils::IndexView &from_full, const utils::IndexView &to_full,
+        const utils::IndexView &from, const utils::IndexView &to,
+        const double *d, budget::Budget &budget, const bool quiet,
+        const bool threaded);
+template std::vector <index_t> slk::slk_tree <float, policy::Longest> (
+        const utils::IndexView &from_full, const utils::IndexView &to_full,
+        const utils::IndexView &from, const utils::IndexView &to,
+        const double *d, budget::Budget &budget, const bool quiet,
+        const bool threaded);
+template std::vector <index_t> slk::slk_tree <double, policy::Shortest> (
+        const utils::IndexView &from_full, const utils::IndexView &to_full,
+        const utils::IndexView &from, const utils::IndexView &to,
+        const double *d, budget::Budget &budget, const bool quiet,
+        const bool threaded);
+template std::vector <index_t> slk::slk_tree <double, policy::Longest> (
+        const utils::IndexView &from_full, const utils::IndexView &to_full,
+        const utils::IndexView &from, const utils::IndexView &to,
+        const double *d, budget::Budget &budget, const bool quiet,
+        const bool threaded);
+
+// Single linkage only compares the distances between neighbouring vertices,
+// and not those of the full edge list, so only the former need be ranked.
+std::vector <policy::rank_t> slk::rank_dists (const Rcpp::NumericVector &d,
+        const std::string &precision, const bool shortest) {
+    std::vector <policy::rank_t> ranks;
+    if (precision == "rank") {
+        ranks = radix_sort::ranks (d.begin (),
+                static_cast <size_t> (d.size ()), shortest);
+    }
+    return ranks;
+}
+
 //' rcpp_slk
 //'
 //' Full-order single linkage cluster redcap algorithm
 //'
+//' @param time_budget Maximal time in seconds, with `Inf` for no limit
+//'
+//' @return Indices into `gr` of the edges of the tree, with a "partial"
+//' attribute which is `TRUE` if the time budget expired before the tree was
+//' complete, in which case it was completed from the remaining edges of `gr`.
 //' @noRd
 // [[Rcpp::export]]
 Rcpp::IntegerVector rcpp_slk (
         const Rcpp::DataFrame gr_full,
         const Rcpp::DataFrame gr,
         const bool shortest,
-        const bool quiet) {
+        const bool quiet,
+        const std::string precision,
+        const double time_budget) {
+    budget::Budget budget (time_budget);
+
+    // Columns are not copied here: the views wrap the data.frame memory, and
+    // convert R's 1-indexed vertex numbers to 0-indexed values on access.
     Rcpp::IntegerVector from_full_ref = gr_full ["from"];
     Rcpp::IntegerVector to_full_ref = gr_full ["to"];
-    Rcpp::NumericVector d_full = gr_full ["d"];
     Rcpp::IntegerVector from_ref = gr ["from"];
     Rcpp::IntegerVector to_ref = gr ["to"];
     Rcpp::NumericVector d = gr ["d"];
 
-    // Rcpp classes are always passed by reference, so cloning is necessary to
-    // avoid modifying the original data.frames.
-    Rcpp::IntegerVector from_full = Rcpp::clone (from_full_ref);
-    Rcpp::IntegerVector to_full = Rcpp::clone (to_full_ref);
-    Rcpp::IntegerVector from = Rcpp::clone (from_ref);
-    Rcpp::IntegerVector to = Rcpp::clone (to_ref);
-
-    // Index vectors are 1-indexed, so
-    from_full = from_full - 1;
-    to_full = to_full - 1;
-    from = from - 1;
-    to = to - 1;
-
-    arma::Mat <int> contig_mat;
-    arma::Mat <double> d_mat;
-
-    // index2cl and cl2index are dynamically updated with cluster memberships;
-    // vert2index and index2vert are retained at initial values which map (from,
-    // to) vectors to matrix indices. All operations are performed on matrices
-    // directly, with membership re-traced at the end via index2vert_map.
-    int2indxset_map_t cl2index_map;
-    int2indx_map_t vert2index_map;
-    indx2int_map_t index2vert_map, index2cl_map;
-
-    size_t n = utils::sets_init (from, to, vert2index_map, index2vert_map,
-                          index2cl_map, cl2index_map);
-
-    utils_slk::mats_init (from, to, d, vert2index_map, contig_mat, d_mat,
+    const utils::IndexView from_full (from_full_ref), to_full (to_full_ref),
+          from (from_ref), to (to_ref);
+
+    const std::vector <policy::rank_t> ranks = slk::rank_dists (d, precision,
             shortest);
+    const policy::Dists dists {d.begin (), ranks.data ()};
 
-    /* The contiguity matrix retains is shape, so is always indexed by the
-     * (from, to) vectors. Merging clusters simply switches additional entries
-     * from  0 to 1.
-     */
+    std::vector <index_t> treevec = policy::dispatch_order <slk::SLKTree> (
+            precision, shortest, from_full, to_full, from, to, dists, budget,
+            quiet);
 
-    const bool really_quiet = !(!quiet && n > 100);
-
-    indxset_t the_tree;
-    size_t e = 0; // edge number in gr_full
-    while (the_tree.size () < (n - 1)) {// tree has n - 1 edges
-        Rcpp::checkUserInterrupt ();
-
-        index_t ifrom = vert2index_map.at (from_full (e)),
-                ito = vert2index_map.at (to_full (e));
-        if (index2cl_map.find (ifrom) != index2cl_map.end () &&
-                index2cl_map.find (ito) != index2cl_map.end ()) {
-            int cfrom = index2cl_map.at (ifrom),
-                cto = index2cl_map.at (ito);
-            if (cfrom != cto &&
-                    contig_mat (static_cast <arma::uword> (ifrom),
-                                static_cast <arma::uword> (ito)) > 0) {
-                size_t ishort = utils::find_shortest_connection (from, to,
-                        vert2index_map, d_mat, cl2index_map, cfrom, cto,
-                        shortest);
-                the_tree.insert (ishort);
-                utils::merge_clusters (contig_mat,
-                        index2cl_map, cl2index_map, cfrom, cto);
-                e = 0;
-            } else {
-                e++;
-            }
-        } else {
-            e++;
-        }
-        if (!really_quiet && the_tree.size () % 100 == 0) {
-            Rcpp::Rcout << "\rBuilding tree: " << the_tree.size () << " / " <<
-                n - 1;
-            Rcpp::Rcout.flush ();
-        }
-    }
+    Rcpp::IntegerVector out = Rcpp::wrap (treevec);
+    out.attr ("partial") = budget.expired ();
+    return out;
+}
 
-    if (!really_quiet) {
-        Rcpp::Rcout << "\rBuilding tree: " << the_tree.size () << " / " <<
-            n - 1 << " -> done" << std::endl;
-    }
+//' rcpp_slk_external
+//'
+//' Full-order single linkage cluster redcap algorithm, with the full edge list
+//' generated from coordinates and sorted on disk.
+//'
+//' @param xy Numeric matrix of coordinates
+//' @param prefix Path prefix for temporary files
+//' @param max_edges Maximal number of edges held in memory while sorting
+//' @param time_budget As for `rcpp_slk`, including the time taken to sort
+//' @noRd
+// [[Rcpp::export]]
+Rcpp::IntegerVector rcpp_slk_external (
+        const Rcpp::NumericMatrix xy,
+        const Rcpp::DataFrame gr,
+        const bool shortest,
+        const bool quiet,
+        const std::string precision,
+        const std::string prefix,
+        const double max_edges,
+        const double time_budget) {
+    budget::Budget budget (time_budget);
+
+    Rcpp::IntegerVector from_ref = gr ["from"];
+    Rcpp::IntegerVector to_ref = gr ["to"];
+    Rcpp::NumericVector d = gr ["d"];
+
+    const utils::IndexView from (from_ref), to (to_ref);
+
+    edge_sort::TempFiles tmp;
+    const std::string path = edge_sort::sort_edges (xy, shortest, prefix,
+            static_cast <size_t> (max_edges), tmp);
+    edge_sort::EdgeSource edges_full (path);
+
+    const std::vector <policy::rank_t> ranks = slk::rank_dists (d, precision,
+            shortest);
+    const policy::Dists dists {d.begin (), ranks.data ()};
 
-    std::vector <index_t> treevec (the_tree.begin (), the_tree.end ());
+    std::vector <index_t> treevec = policy::dispatch_order <slk::SLKTreeEdges> (
+            precision, shortest, edges_full, from, to, dists, budget, quiet);
 
-    return Rcpp::wrap (treevec);
+    Rcpp::IntegerVector out = Rcpp::wrap (treevec);
+    out.attr ("partial") = budget.expired ();
+    return out;
 }
@@ -1,9 +1,114 @@
 #pragma once
 
+#include "agglomerate.h"
+#include "edge-sort.h"
+
 // --------- SINGLE LINKAGE CLUSTER ----------------
 
+namespace slk {
+
+constexpr size_t NONE = std::numeric_limits <size_t>::max ();
+// Maximal number of edges held in `pending`
+constexpr size_t MAX_PENDING = 16 * edge_sort::BUFFER_EDGES;
+
+// Linkage policy for the shared agglomeration core. Each step merges the
+// clusters joined by the first edge of the full, sorted edge list which
+// connects two different, contiguous clusters. The edge list may be held in
+// memory, or streamed from a sorted file.
+//
+// Edges within a single cluster can never be selected again, while edges
+// between non-contiguous clusters may become contiguous after later merges.
+// Rather than rescanning the whole list for each merge, the latter are held in
+// `pending`, in sorted order, and the list is read on from where the previous
+// step stopped. `pending` is limited to MAX_PENDING edges, regardless of the
+// size of the list. Once full, reading resumes from the first edge not held,
+// at `overflow`, once `pending` has been exhausted.
+template <typename T>
+struct SLKLinkage {
+    edge_sort::EdgeSource &edges_full;
+    std::vector <edge_sort::Edge> pending;
+    size_t overflow = NONE;
+
+    explicit SLKLinkage (edge_sort::EdgeSource &edges_full_in) :
+        edges_full (edges_full_in) {}
+
+    bool next (agglomerate::AggDat <T> &dat, agglomerate::MergePair &pr);
+    void update (agglomerate::AggDat <T> &dat,
+            const agglomerate::MergePair &pr);
+};
+
+template <typename T, typename Cmp>
+std::vector <index_t> slk_tree (
+        const utils::IndexView &from_full,
+        const utils::IndexView &to_full,
+        const utils::IndexView &from,
+        const utils::IndexView &to,
+        const typename policy::Input <T>::type *d,
+        budget::Budget &budget,
+        const bool quiet,
+        const bool threaded = false);
+
+template <typename T, typename Cmp>
+std::vector <index_t> slk_tree_edges (
+        edge_sort::EdgeSource &edges_full,
+        const utils::IndexView &from,
+        const utils::IndexView &to,
+        const typename policy::Input <T>::type *d,
+        budget::Budget &budget,
+        const bool quiet,
+        const bool threaded = false);
+
+// Ranks of neighbour distances for precision "rank", or an empty vector for
+// all other precisions.
+std::vector <policy::rank_t> rank_dists (const Rcpp::NumericVector &d,
+        const std::string &precision, const bool shortest);
+
+// Targets for policy::dispatch_order
+struct SLKTree {
+    template <typename T, typename Cmp>
+    static std::vector <index_t> run (
+            const utils::IndexView &from_full,
+            const utils::IndexView &to_full,
+            const utils::IndexView &from,
+            const utils::IndexView &to,
+            const policy::Dists &d,
+            budget::Budget &budget,
+            const bool quiet) {
+        return slk_tree <T, Cmp> (from_full, to_full, from, to,
+                d.template get <T> (), budget, quiet);
+    }
+};
+
+struct SLKTreeEdges {
+    template <typename T, typename Cmp>
+    static std::vector <index_t> run (
+            edge_sort::EdgeSource &edges_full,
+            const utils::IndexView &from,
+            const utils::IndexView &to,
+            const policy::Dists &d,
+            budget::Budget &budget,
+            const bool quiet) {
+        return slk_tree_edges <T, Cmp> (edges_full, from, to,
+                d.template get <T> (), budget, quiet);
+    }
+};
+
+} // end namespace slk
+
 Rcpp::IntegerVector rcpp_slk (
         const Rcpp::DataFrame gr_full,
         const Rcpp::DataFrame gr,
         const bool shortest,
-        const bool quiet);
+        const bool quiet,
+        const std::string precision,
+        const double time_budget);
+
+Rcpp::IntegerVector rcpp_slk_external (
+        const Rcpp::NumericMatrix xy,
+        const Rcpp::DataFrame gr,
+        const bool shortest,
+        const bool quiet,
+        const std::string precision,
+        const std::string prefix,
+        const double max_edges,
+        const double time_budget);
@@ -8,22 +8,62 @@
 */
 
 /* .Call calls */
-extern SEXP _spatialcluster_rcpp_alk(SEXP, SEXP, SEXP);
-extern SEXP _spatialcluster_rcpp_clk(SEXP, SEXP, SEXP, SEXP);
-extern SEXP _spatialcluster_rcpp_cut_tree(SEXP, SEXP, SEXP, SEXP);
-extern SEXP _spatialcluster_rcpp_full_initial(SEXP, SEXP);
-extern SEXP _spatialcluster_rcpp_full_merge(SEXP, SEXP, SEXP);
-extern SEXP _spatialcluster_rcpp_mst(SEXP);
-extern SEXP _spatialcluster_rcpp_slk(SEXP, SEXP, SEXP, SEXP);
+extern SEXP _spatialcluster_rcpp_ahulls(SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP _spatialcluster_rcpp_alk(SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP _spatialcluster_rcpp_clk(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP _spatialcluster_rcpp_clk_external(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP _spatialcluster_rcpp_cut_tree(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP _spatialcluster_rcpp_cut_tree_batch(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP _spatialcluster_rcpp_dmat_file_edges(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP _spatialcluster_rcpp_emst(SEXP, SEXP);
+extern SEXP _spatialcluster_rcpp_feature_edges(SEXP, SEXP, SEXP, SEXP);
+extern SEXP _spatialcluster_rcpp_full_cut(SEXP, SEXP, SEXP, SEXP);
+extern SEXP _spatialcluster_rcpp_full_initial(SEXP, SEXP, SEXP);
+extern SEXP _spatialcluster_rcpp_full_merge(SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP _spatialcluster_rcpp_insert_points(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP _spatialcluster_rcpp_kernel_edges(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP _spatialcluster_rcpp_knn(SEXP, SEXP, SEXP, SEXP);
+extern SEXP _spatialcluster_rcpp_merges_hclust(SEXP);
+extern SEXP _spatialcluster_rcpp_mst(SEXP, SEXP);
+extern SEXP _spatialcluster_rcpp_radix_order(SEXP, SEXP, SEXP);
+extern SEXP _spatialcluster_rcpp_redcap_many(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP _spatialcluster_rcpp_remove_points(SEXP, SEXP, SEXP, SEXP);
+extern SEXP _spatialcluster_rcpp_scl_read(SEXP);
+extern SEXP _spatialcluster_rcpp_scl_write(SEXP, SEXP);
+extern SEXP _spatialcluster_rcpp_slk(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP _spatialcluster_rcpp_slk_external(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP _spatialcluster_rcpp_statistics(SEXP, SEXP, SEXP, SEXP);
+extern SEXP _spatialcluster_rcpp_timeseries_edges(SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP _spatialcluster_rcpp_xy_dists(SEXP, SEXP, SEXP);
 
 static const R_CallMethodDef CallEntries[] = {
-    {"_spatialcluster_rcpp_alk",          (DL_FUNC) &_spatialcluster_rcpp_alk,          3},
-    {"_spatialcluster_rcpp_clk",          (DL_FUNC) &_spatialcluster_rcpp_clk,          4},
-    {"_spatialcluster_rcpp_cut_tree",     (DL_FUNC) &_spatialcluster_rcpp_cut_tree,     4},
-    {"_spatialcluster_rcpp_full_initial", (DL_FUNC) &_spatialcluster_rcpp_full_initial, 2},
-    {"_spatialcluster_rcpp_full_merge",   (DL_FUNC) &_spatialcluster_rcpp_full_merge,   3},
-    {"_spatialcluster_rcpp_mst",          (DL_FUNC) &_spatialcluster_rcpp_mst,          1},
-    {"_spatialcluster_rcpp_slk",          (DL_FUNC) &_spatialcluster_rcpp_slk,          4},
+    {"_spatialcluster_rcpp_ahulls",           (DL_FUNC) &_spatialcluster_rcpp_ahulls,           5},
+    {"_spatialcluster_rcpp_alk",              (DL_FUNC) &_spatialcluster_rcpp_alk,              5},
+    {"_spatialcluster_rcpp_clk",              (DL_FUNC) &_spatialcluster_rcpp_clk,              6},
+    {"_spatialcluster_rcpp_clk_external",     (DL_FUNC) &_spatialcluster_rcpp_clk_external,     8},
+    {"_spatialcluster_rcpp_cut_tree",         (DL_FUNC) &_spatialcluster_rcpp_cut_tree,         9},
+    {"_spatialcluster_rcpp_cut_tree_batch",   (DL_FUNC) &_spatialcluster_rcpp_cut_tree_batch,   10},
+    {"_spatialcluster_rcpp_dmat_file_edges",  (DL_FUNC) &_spatialcluster_rcpp_dmat_file_edges,  6},
+    {"_spatialcluster_rcpp_emst",             (DL_FUNC) &_spatialcluster_rcpp_emst,             2},
+    {"_spatialcluster_rcpp_feature_edges",    (DL_FUNC) &_spatialcluster_rcpp_feature_edges,    4},
+    {"_spatialcluster_rcpp_full_cut",         (DL_FUNC) &_spatialcluster_rcpp_full_cut,         4},
+    {"_spatialcluster_rcpp_full_initial",     (DL_FUNC) &_spatialcluster_rcpp_full_initial,     3},
+    {"_spatialcluster_rcpp_full_merge",       (DL_FUNC) &_spatialcluster_rcpp_full_merge,       5},
+    {"_spatialcluster_rcpp_insert_points",    (DL_FUNC) &_spatialcluster_rcpp_insert_points,    6},
+    {"_spatialcluster_rcpp_kernel_edges",     (DL_FUNC) &_spatialcluster_rcpp_kernel_edges,     6},
+    {"_spatialcluster_rcpp_knn",              (DL_FUNC) &_spatialcluster_rcpp_knn,              4},
+    {"_spatialcluster_rcpp_merges_hclust",    (DL_FUNC) &_spatialcluster_rcpp_merges_hclust,    1},
+    {"_spatialcluster_rcpp_mst",              (DL_FUNC) &_spatialcluster_rcpp_mst,              2},
+    {"_spatialcluster_rcpp_radix_order",      (DL_FUNC) &_spatialcluster_rcpp_radix_order,      3},
+    {"_spatialcluster_rcpp_redcap_many",      (DL_FUNC) &_spatialcluster_rcpp_redcap_many,      9},
+    {"_spatialcluster_rcpp_remove_points",    (DL_FUNC) &_spatialcluster_rcpp_remove_points,    4},
+    {"_spatialcluster_rcpp_scl_read",         (DL_FUNC) &_spatialcluster_rcpp_scl_read,         1},
+    {"_spatialcluster_rcpp_scl_write",        (DL_FUNC) &_spatialcluster_rcpp_scl_write,        2},
+    {"_spatialcluster_rcpp_slk",              (DL_FUNC) &_spatialcluster_rcpp_slk,              6},
+    {"_spatialcluster_rcpp_slk_external",     (DL_FUNC) &_spatialcluster_rcpp_slk_external,     8},
+    {"_spatialcluster_rcpp_statistics",       (DL_FUNC) &_spatialcluster_rcpp_statistics,       4},
+    {"_spatialcluster_rcpp_timeseries_edges", (DL_FUNC) &_spatialcluster_rcpp_timeseries_edges, 5},
+    {"_spatialcluster_rcpp_xy_dists",         (DL_FUNC) &_spatialcluster_rcpp_xy_dists,         3},
     {NULL, NULL, 0}
 };
 
@@ -0,0 +1,167 @@
+#include "common.h"
+#include "statistics.h"
+
+scl_stats::TTest scl_stats::ttest_less (const scl_stats::Moments &x,
+        const scl_stats::Moments &y) {
+
+    if (x.n < 1) {
+        Rcpp::stop ("not enough 'x' observations");
+    }
+    if (y.n < 1) {
+        Rcpp::stop ("not enough 'y' observations");
+    }
+    if (x.n + y.n < 3) {
+        Rcpp::stop ("not enough observations");
+    }
+
+    const double nx = static_cast <double> (x.n),
+          ny = static_cast <double> (y.n),
+          df = nx + ny - 2.0;
+    // m2 is zero for single observations, so (n - 1) * var = m2 throughout
+    const double v = (x.m2 + y.m2) / df;
+    const double se = std::sqrt (v * (1.0 / nx + 1.0 / ny));
+    if (se < 10.0 * std::numeric_limits <double>::epsilon () *
+            std::max (std::fabs (x.mean), std::fabs (y.mean))) {
+        Rcpp::stop ("data are essentially constant");
+    }
+
+    scl_stats::TTest res;
+    res.statistic = (x.mean - y.mean) / se;
+    res.parameter = df;
+    res.p_value = R::pt (res.statistic, df, 1, 0);
+
+    return res;
+}
+
+//' rcpp_statistics
+//'
+//' t-statistics comparing distances of edges within each cluster to those of
+//' edges between clusters, along with summaries of each cluster.
+//'
+//' @param tree Tree with columns of (from, to, d, cluster)
+//' @param node_cluster, x, y Clusters and coordinates of each node
+//'
+//' @return List of global and per-cluster t-statistics, and per-cluster
+//' summaries.
+//' @noRd
+// [[Rcpp::export]]
+Rcpp::List rcpp_statistics (
+        const Rcpp::DataFrame tree,
+        const Rcpp::NumericVector node_cluster,
+        const Rcpp::NumericVector x,
+        const Rcpp::NumericVector y) {
+
+    const Rcpp::IntegerVector from = tree ["from"];
+    const Rcpp::IntegerVector to = tree ["to"];
+    const Rcpp::NumericVector d = tree ["d"];
+    const Rcpp::NumericVector cluster = tree ["cluster"];
+    const R_xlen_t m = from.size ();
+
+    // Edges between clusters are all those which do not join the same pair of
+    // vertices as any edge within a cluster.
+    std::unordered_set <uint64_t> pairs_in;
+    scl_stats::Moments in, out;
+    // Numbers of edges and distances within each cluster
+    std::map <double, std::pair <size_t, scl_stats::Moments> > clusters;
+    for (R_xlen_t i = 0; i < m; i++) {
+        if (ISNAN (cluster [i])) {
+            continue;
+        }
+        auto &cl = clusters [cluster [i]];
+        if (cluster [i] < 0.0) {
+            continue;
+        }
+        pairs_in.emplace ((static_cast <uint64_t> (
+                        static_cast <uint32_t> (from [i])) << 32) |
+                static_cast <uint32_t> (to [i]));
+        cl.first++;
+        if (!ISNAN (d [i])) {
+            cl.second.add (d [i]);
+            in.add (d [i]);
+        }
+    }
+    for (R_xlen_t i = 0; i < m; i++) {
+        const uint64_t pair = (static_cast <uint64_t> (
+                    static_cast <uint32_t> (from [i])) << 32) |
+            static_cast <uint32_t> (to [i]);
+        if (!ISNAN (d [i]) && pairs_in.find (pair) == pairs_in.end ()) {
+            out.add (d [i]);
+        }
+    }
+
+    const scl_stats::TTest tt = scl_stats::ttest_less (in, out);
+    Rcpp::NumericVector tt_global = Rcpp::NumericVector::create (
+            Rcpp::Named ("statistic") = tt.statistic,
+            Rcpp::Named ("parameter") = tt.parameter,
+            Rcpp::Named ("p.value") = tt.p_value);
+
+    // Clusters with <= 3 edges have no statistics
+    Rcpp::NumericMatrix tt_clusters (static_cast <int> (clusters.size ()), 3);
+    int row = 0;
+    for (auto cl: clusters) {
+        if (cl.second.first <= 3) {
+            for (int j = 0; j < 3; j++) {
+                tt_clusters (row, j) = NA_REAL;
+            }
+        } else {
+            const scl_stats::TTest tti =
+                scl_stats::ttest_less (cl.second.second, out);
+            tt_clusters (row, 0) = tti.statistic;
+            tt_clusters (row, 1) = tti.parameter;
+            tt_clusters (row, 2) = tti.p_value;
+        }
+        row++;
+    }
+    std::vector <std::string> colnames {"statistic", "parameter", "p.value"};
+    Rcpp::List dimnames (2);
+    dimnames (1) = colnames;
+    tt_clusters.attr ("dimnames") = dimnames;
+
+    // Summaries of the nodes in each cluster
+    std::map <double, scl_stats::Summary> summaries;
+    for (R_xlen_t i = 0; i < node_cluster.size (); i++) {
+        if (ISNAN (node_cluster [i])) {
+            continue;
+        }
+        scl_stats::Summary &s = summaries [node_cluster [i]];
+        s.n++;
+        s.x += x [i];
+        s.y += y [i];
+        s.xmin = std::min (s.xmin, x [i]);
+        s.xmax = std::max (s.xmax, x [i]);
+        s.ymin = std::min (s.ymin, y [i]);
+        s.ymax = std::max (s.ymax, y [i]);
+    }
+    const int ns = static_cast <int> (summaries.size ());
+    Rcpp::NumericVector s_cluster (ns), s_x (ns), s_y (ns),
+        s_xmin (ns), s_xmax (ns), s_ymin (ns), s_ymax (ns);
+    Rcpp::IntegerVector s_n (ns);
+    row = 0;
+    for (auto s: summaries) {
+        const double ni = static_cast <double> (s.second.n);
+        s_cluster [row] = s.first;
+        s_n [row] = static_cast <int> (s.second.n);
+        s_x [row] = s.second.x / ni;
+        s_y [row] = s.second.y / ni;
+        s_xmin [row] = s.second.xmin;
+        s_xmax [row] = s.second.xmax;
+        s_ymin [row] = s.second.ymin;
+        s_ymax [row] = s.second.ymax;
+        row++;
+    }
+    Rcpp::DataFrame summary = Rcpp::DataFrame::create (
+        Rcpp::Named ("cluster") = s_cluster,
+        Rcpp::Named ("n") = s_n,
+        Rcpp::Named ("x") = s_x,
+        Rcpp::Named ("y") = s_y,
+        Rcpp::Named ("xmin") = s_xmin,
+        Rcpp::Named ("xmax") = s_xmax,
+        Rcpp::Named ("ymin") = s_ymin,
+        Rcpp::Named ("ymax") = s_ymax,
+        Rcpp::_["stringsAsFactors"] = false);
+
+    return Rcpp::List::create (
+        Rcpp::Named ("tt_global") = tt_global,
+        Rcpp::Named ("tt_clusters") = tt_clusters,
+        Rcpp::Named ("clusters") = summary);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+// --------- CLUSTER STATISTICS ----------------
+
+/* Statistics of clustering schemes, comparing the distances of edges within
+ * clusters to those of edges between clusters, with two-sample t-tests, as for
+ * `stats::t.test (..., alternative = "less", var.equal = TRUE)`. Distances are
+ * accumulated for all clusters at once in a single pass over the tree edges,
+ * with running means and sums of squared deviations.
+ */
+
+namespace scl_stats {
+
+// Running count, mean, and sum of squared deviations from the mean
+struct Moments {
+    size_t n = 0;
+    double mean = 0.0, m2 = 0.0;
+
+    void add (const double x) {
+        n++;
+        const double delta = x - mean;
+        mean += delta / static_cast <double> (n);
+        m2 += delta * (x - mean);
+    }
+};
+
+struct TTest {
+    double statistic, parameter, p_value;
+};
+
+// Two-sample t-test with equal variances of the alternative that the mean of
+// `x` is less than that of `y`.
+TTest ttest_less (const Moments &x, const Moments &y);
+
+// Number of nodes, centroid, and bounding box of one cluster
+struct Summary {
+    size_t n = 0;
+    double x = 0.0, y = 0.0;
+    double xmin = INFINITE_DOUBLE, xmax = -INFINITE_DOUBLE,
+           ymin = INFINITE_DOUBLE, ymax = -INFINITE_DOUBLE;
+};
+
+} // end namespace scl_stats
+
+Rcpp::List rcpp_statistics (
+        const Rcpp::DataFrame tree,
+        const Rcpp::NumericVector node_cluster,
+        const Rcpp::NumericVector x,
+        const Rcpp::NumericVector y);
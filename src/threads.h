@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+// --------- MULTI-THREADING ----------------
+
+/* Minimal parallel loops over std::thread. The function passed to parallel_for
+ * is called with contiguous (begin, end) ranges of indices, one range per
+ * thread, while parallel_for_each calls its function with single indices,
+ * taken in turn by each thread from a shared counter, so that work is balanced
+ * between threads even when items differ in cost. Neither function may call
+ * any R API functions, including Rcpp::stop or Rcpp::checkUserInterrupt, or
+ * allocate any R objects. Errors in worker threads must instead be thrown as
+ * std::exception types, and caught with an `Errors` object, which translates
+ * them to R errors on the main thread once all workers have been joined.
+ */
+
+namespace threads {
+
+// Resolve a requested number of threads against the hardware and the amount
+// of work, with values <= 0 meaning "all available".
+inline size_t num_threads (const int nthreads, const size_t n) {
+    size_t nt = static_cast <size_t> (nthreads);
+    if (nthreads <= 0) {
+        nt = static_cast <size_t> (std::thread::hardware_concurrency ());
+    }
+    if (nt < 1) {
+        nt = 1;
+    }
+    if (nt > n) {
+        nt = n;
+    }
+    return nt;
+}
+
+template <typename F>
+void parallel_for (const size_t n, const int nthreads, F fn) {
+    const size_t nt = threads::num_threads (nthreads, n);
+    if (nt <= 1) {
+        fn (static_cast <size_t> (0), n);
+        return;
+    }
+
+    const size_t chunk = (n + nt - 1) / nt;
+    std::vector <std::thread> pool;
+    pool.reserve (nt);
+    for (size_t t = 0; t < nt; t++) {
+        const size_t begin = t * chunk,
+                     end = std::min (n, begin + chunk);
+        if (begin >= end) {
+            break;
+        }
+        pool.emplace_back (fn, begin, end);
+    }
+    for (auto &th: pool) {
+        th.join ();
+    }
+}
+
+template <typename F>
+void parallel_for_each (const size_t n, const int nthreads, F fn) {
+    const size_t nt = threads::num_threads (nthreads, n);
+    if (nt <= 1) {
+        for (size_t i = 0; i < n; i++) {
+            fn (i);
+        }
+        return;
+    }
+
+    std::atomic <size_t> next (0);
+    auto worker = [&next, &fn, n] () {
+        for (size_t i = next++; i < n; i = next++) {
+            fn (i);
+        }
+    };
+
+    std::vector <std::thread> pool;
+    pool.reserve (nt);
+    for (size_t t = 0; t < nt; t++) {
+        pool.emplace_back (worker);
+    }
+    for (auto &th: pool) {
+        th.join ();
+    }
+}
+
+// Messages of exceptions thrown by each of `n` items run in worker threads.
+class Errors {
+    std::vector <std::string> msgs;
+
+public:
+    explicit Errors (const size_t n) : msgs (n) {}
+
+    // Run `fn` for item `i`, catching and storing any exception.
+    template <typename F>
+    void run (const size_t i, F fn) {
+        try {
+            fn ();
+        } catch (const std::exception &e) {
+            msgs [i] = e.what ();
+            if (msgs [i].empty ()) {
+                msgs [i] = "unknown error";
+            }
+        } catch (...) {
+            msgs [i] = "unknown error";
+        }
+    }
+
+    // Call Rcpp::stop with the message of the first failed item, preceded by
+    // `prefix` and the 1-based number of that item. Only to be called from the
+    // main thread.
+    void stop (const std::string &prefix) const {
+        for (size_t i = 0; i < msgs.size (); i++) {
+            if (!msgs [i].empty ()) {
+                Rcpp::stop (prefix + std::to_string (i + 1) + ": " +
+                        msgs [i]);
+            }
+        }
+    }
+};
+
+} // end namespace threads
@@ -1,5 +1,6 @@
 #include "common.h"
 #include "utils.h"
+#include "policies.h"
 #include <algorithm>
 
 // Note that all matrices **CAN** be asymmetrical, and so are always indexed
@@ -13,8 +14,12 @@
  * sequential index numbers into the matrices (dists, contig_mat, whatever). The
  * latter are initially direct a->a maps of all indices to themselves. As
  * clusters merge, the values of index2cl maps are updated so that, for example,
- * index2cl(a)->b and index2cl(b)->b. The cl2index map then holds an
- * unordered_set of target indices for each cluster.
+ * index2cl(a)->b and index2cl(b)->b. The cl2index map then holds the
+ * member indices of each cluster.
+ *
+ * The vertex maps are dense vectors, indexed directly by vertex or index
+ * numbers, while the cluster maps are held in a utils::ClusterMembers object,
+ * so lookups in the inner loops involve no hashing.
  */
 
 bool utils::strfound (const std::string str, const std::string target) {
@@ -25,47 +30,39 @@ bool utils::strfound (const std::string str, const std::string target) {
 }
 
 size_t utils::sets_init (
-        const Rcpp::IntegerVector &from,
-        const Rcpp::IntegerVector &to,
-        int2indx_map_t &vert2index_map,
-        indx2int_map_t &index2vert_map,
-        indx2int_map_t &index2cl_map,
-        int2indxset_map_t &cl2index_map) {
-    vert2index_map.clear ();
-    index2vert_map.clear ();
-    index2cl_map.clear ();
-    cl2index_map.clear ();
-
-    intset_t vert_set;
+        const utils::IndexView &from,
+        const utils::IndexView &to,
+        int2indx_vec_t &vert2index,
+        indx2int_vec_t &index2vert,
+        utils::ClusterMembers &clusters) {
+    int max_vert = -1;
     for (int i = 0; i < from.size (); i++) {
-        vert_set.emplace (from [i]);
-        vert_set.emplace (to [i]);
-    }
-    int idx = 0;
-    for (auto v: vert_set) {
-        index2vert_map.emplace (idx, v);
-        vert2index_map.emplace (v, idx++);
+        if (from [i] < 0 || to [i] < 0) {
+            throw std::runtime_error ("vertex numbers must be positive");
+        }
+        max_vert = std::max (max_vert, std::max (from [i], to [i]));
     }
 
-    for (int i = 0; i < from.length (); i++) {
-        size_t fi = vert2index_map.at (from [i]);
-        indxset_t eset; // only one index for each vert at this stage
-        eset.insert (fi);
-        cl2index_map.emplace (fi, eset);
+    // Single compaction pass to map (potentially sparse) vertex numbers onto
+    // sequential indices, in increasing order of vertex number.
+    vert2index.assign (static_cast <size_t> (max_vert + 1), NO_INDEX);
+    for (int i = 0; i < from.size (); i++) {
+        vert2index [static_cast <size_t> (from [i])] = 0;
+        vert2index [static_cast <size_t> (to [i])] = 0;
     }
-    for (auto v: vert_set) {
-        // all verts are their own clusters, so cast indx to cli
-        int cli = static_cast <int> (vert2index_map.at (v));
-        indxset_t eset;
-        if (cl2index_map.find (cli) != cl2index_map.end ()) {
-            eset = cl2index_map.at (cli);
+    index2vert.clear ();
+    for (size_t v = 0; v < vert2index.size (); v++) {
+        if (vert2index [v] != NO_INDEX) {
+            vert2index [v] = index2vert.size ();
+            index2vert.push_back (static_cast <int> (v));
         }
-        eset.emplace (cli);
-        cl2index_map.emplace (cli, eset);
-        index2cl_map.emplace (static_cast <size_t> (cli), cli);
     }
-    
-    return static_cast <size_t> (vert_set.size ());
+
+    // All vertices are initially their own clusters
+    const size_t n = index2vert.size ();
+    clusters.init (n);
+
+    return n;
 }
 
 //' find shortest (or longest) connection between two clusters
@@ -77,29 +74,23 @@ size_t utils::sets_init (
 //'
 //' @return Index directly into from, to - **NOT** into the actual matrices!
 //' @noRd
+template <typename T, typename Cmp>
 size_t utils::find_shortest_connection (
-        const Rcpp::IntegerVector &from,
-        const Rcpp::IntegerVector &to,
-        const int2indx_map_t &vert2index_map,
-        const arma::Mat <double> &d_mat,
-        const int2indxset_map_t &cl2index_map,
+        const utils::IndexView &from,
+        const utils::IndexView &to,
+        const int2indx_vec_t &vert2index,
+        const arma::Mat <T> &d_mat,
+        const utils::ClusterMembers &clusters,
         const int cfrom,
-        const int cto,
-        const bool shortest) {
-    if (cl2index_map.find (cfrom) == cl2index_map.end ()) {
-        Rcpp::stop ("cluster index not found");
-    }
-    if (cl2index_map.find (cto) == cl2index_map.end ()) {
-        Rcpp::stop ("cluster index not found");
+        const int cto) {
+    if (!clusters.active (cfrom) || !clusters.active (cto)) {
+        throw std::runtime_error ("cluster index not found");
     }
 
-    indxset_t index_i = cl2index_map.at (cfrom),
-             index_j = cl2index_map.at (cto);
+    const std::vector <index_t> &index_i = clusters.members (cfrom),
+          &index_j = clusters.members (cto);
 
-    double dlim = INFINITE_DOUBLE;
-    if (!shortest) {
-        dlim = -dlim;
-    }
+    T dlim = Cmp::template worst <T> ();
     size_t short_i = INFINITE_INT, short_j = INFINITE_INT;
 
     // from and to here are directional, so need to examine both directions
@@ -107,42 +98,98 @@ size_t utils::find_shortest_connection (
         for (auto j: index_j) {
             arma::uword ia = static_cast <arma::uword> (i),
                         ja = static_cast <arma::uword> (j);
-            if ((shortest && d_mat (ia, ja) < dlim) ||
-                    (!shortest && d_mat (ia, ja) > dlim)) {
+            if (Cmp::better (d_mat (ia, ja), dlim)) {
                 dlim = d_mat (ia, ja);
                 short_i = i;
                 short_j = j;
-            } else if ((shortest && d_mat (ja, ia) < dlim) ||
-                    (!shortest && d_mat (ja, ia) > dlim)) {
+            } else if (Cmp::better (d_mat (ja, ia), dlim)) {
                 dlim = d_mat (ja, ia);
                 short_i = j;
                 short_j = i;
             }
         }
     }
-    if (dlim == INFINITE_DOUBLE) {
-        Rcpp::stop ("no minimal distance; this should not happen");
+    if (dlim == Cmp::template worst <T> ()) {
+        throw std::runtime_error (
+                "no minimal distance; this should not happen");
     }
 
     // convert short_i and short_j to a single edge 
     // TODO: Make a std::map of vert2dist to avoid this loop
     size_t shortest_edge = INFINITE_INT;
     for (int i = 0; i < from.length (); i++) { // int for Rcpp index
-        if ((vert2index_map.at (from [i]) == short_i &&
-                vert2index_map.at (to [i]) == short_j) ||
-            (vert2index_map.at (from [i]) == short_j &&
-                vert2index_map.at (to [i]) == short_i)) {
+        const index_t fi = utils::vert_index (vert2index, from [i]),
+                      ti = utils::vert_index (vert2index, to [i]);
+        if ((fi == short_i && ti == short_j) ||
+                (fi == short_j && ti == short_i)) {
             shortest_edge = static_cast <size_t> (i);
             break;
         }
     }
     if (shortest_edge == INFINITE_INT) {
-        Rcpp::stop ("This shouldn't happen (in utils::find_shortest_connection)");
+        throw std::runtime_error (
+                "This shouldn't happen (in utils::find_shortest_connection)");
     }
 
     return shortest_edge;
 }
 
+template size_t utils::find_shortest_connection <float, policy::Shortest> (
+        const utils::IndexView &from,
+        const utils::IndexView &to,
+        const int2indx_vec_t &vert2index,
+        const arma::Mat <float> &d_mat,
+        const utils::ClusterMembers &clusters,
+        const int cfrom,
+        const int cto);
+
+template size_t utils::find_shortest_connection <float, policy::Longest> (
+        const utils::IndexView &from,
+        const utils::IndexView &to,
+        const int2indx_vec_t &vert2index,
+        const arma::Mat <float> &d_mat,
+        const utils::ClusterMembers &clusters,
+        const int cfrom,
+        const int cto);
+
+template size_t utils::find_shortest_connection <double, policy::Shortest> (
+        const utils::IndexView &from,
+        const utils::IndexView &to,
+        const int2indx_vec_t &vert2index,
+        const arma::Mat <double> &d_mat,
+        const utils::ClusterMembers &clusters,
+        const int cfrom,
+        const int cto);
+
+template size_t utils::find_shortest_connection <double, policy::Longest> (
+        const utils::IndexView &from,
+        const utils::IndexView &to,
+        const int2indx_vec_t &vert2index,
+        const arma::Mat <double> &d_mat,
+        const utils::ClusterMembers &clusters,
+        const int cfrom,
+        const int cto);
+
+template size_t utils::find_shortest_connection <policy::rank_t,
+        policy::Shortest> (
+        const utils::IndexView &from,
+        const utils::IndexView &to,
+        const int2indx_vec_t &vert2index,
+        const arma::Mat <policy::rank_t> &d_mat,
+        const utils::ClusterMembers &clusters,
+        const int cfrom,
+        const int cto);
+
+template size_t utils::find_shortest_connection <policy::rank_t,
+        policy::Longest> (
+        const utils::IndexView &from,
+        const utils::IndexView &to,
+        const int2indx_vec_t &vert2index,
+        const arma::Mat <policy::rank_t> &d_mat,
+        const utils::ClusterMembers &clusters,
+        const int cfrom,
+        const int cto);
+
 //' merge two clusters in the contiguity matrix, reducing the size of the matrix
 //' by one row and column.
 //'
@@ -151,15 +198,14 @@ size_t utils::find_shortest_connection (
 //' @noRd
 void utils::merge_clusters (
         arma::Mat <int> &contig_mat,
-        indx2int_map_t &index2cl_map,
-        int2indxset_map_t &cl2index_map,
+        utils::ClusterMembers &clusters,
         const int cluster_from,
         const int cluster_to) {
     if (cluster_from < 0) {
-        Rcpp::stop ("cluster_from must be non-negative");
+        throw std::runtime_error ("cluster_from must be non-negative");
     }
     if (cluster_to < 0) {
-        Rcpp::stop ("cluster_to must be non-negative");
+        throw std::runtime_error ("cluster_to must be non-negative");
     }
 
     arma::uword cfr = static_cast <arma::uword> (cluster_from),
@@ -172,8 +218,8 @@ void utils::merge_clusters (
         }
     }
 
-    indxset_t idx_from = cl2index_map.at (cluster_from),
-              idx_to = cl2index_map.at (cluster_to);
+    const std::vector <index_t> &idx_from = clusters.members (cluster_from),
+          &idx_to = clusters.members (cluster_to);
 
     for (auto i: idx_from) {
         for (auto j: idx_to) {
@@ -183,48 +229,84 @@ void utils::merge_clusters (
         }
     }
 
-    // then re-number all cluster numbers in cl2index 
-    cl2index_map.erase (cluster_from);
-    cl2index_map.erase (cluster_to);
-    for (auto i: idx_from) {
-        idx_to.insert (i);
-    }
-    cl2index_map.emplace (cluster_to, idx_to);
-    // and in index2cl:
-    for (auto i: idx_from) {
-        index2cl_map.erase (i);
-        index2cl_map.emplace (i, cluster_to);
-    }
+    clusters.merge (cluster_from, cluster_to);
 }
 
 //' initial contiguity and distance matrices. The contiguity matrix is between
 //' clusters, so is constantly modified, whereas the distance matrix is between
 //' edges, so is fixed at load time.
 //' @noRd
+template <typename T, typename Cmp>
 void utils_slk::mats_init (
-        const Rcpp::IntegerVector &from,
-        const Rcpp::IntegerVector &to,
-        const Rcpp::NumericVector &d,
-        const int2indx_map_t &vert2index_map,
+        const utils::IndexView &from,
+        const utils::IndexView &to,
+        const typename policy::Input <T>::type *d,
+        const int2indx_vec_t &vert2index,
         arma::Mat <int> &contig_mat,
-        arma::Mat <double> &d_mat,
-        bool shortest) {
+        arma::Mat <T> &d_mat) {
     // arma::uword = unsigned int
-    const arma::uword n = static_cast <arma::uword> (vert2index_map.size ());
+    const arma::uword n = static_cast <arma::uword> (std::count_if (
+                vert2index.begin (), vert2index.end (),
+                [] (const index_t i) { return i != NO_INDEX; }));
 
     contig_mat = arma::zeros <arma::Mat <int> > (n, n);
-    //d_mat = arma::zeros <arma::Mat <double> > (n, n);
     d_mat.resize (n, n);
-    if (shortest) {
-        d_mat.fill (INFINITE_DOUBLE);
-    } else {
-        d_mat.fill (-INFINITE_DOUBLE);
-    }
+    d_mat.fill (Cmp::template worst <T> ());
 
     for (int i = 0; i < from.length (); i++) {
-        arma::uword fi = static_cast <arma::uword> (vert2index_map.at (from [i])),
-                    ti = static_cast <arma::uword> (vert2index_map.at (to [i]));
+        arma::uword fi = static_cast <arma::uword> (
+                            utils::vert_index (vert2index, from [i])),
+                    ti = static_cast <arma::uword> (
+                            utils::vert_index (vert2index, to [i]));
         contig_mat (fi, ti) = contig_mat (ti, fi) = 1;
-        d_mat (fi, ti) = d_mat (ti, fi) = d [i];
+        d_mat (fi, ti) = d_mat (ti, fi) = static_cast <T> (d [i]);
     }
 }
+
+template void utils_slk::mats_init <float, policy::Shortest> (
+        const utils::IndexView &from,
+        const utils::IndexView &to,
+        const double *d,
+        const int2indx_vec_t &vert2index,
+        arma::Mat <int> &contig_mat,
+        arma::Mat <float> &d_mat);
+
+template void utils_slk::mats_init <float, policy::Longest> (
+        const utils::IndexView &from,
+        const utils::IndexView &to,
+        const double *d,
+        const int2indx_vec_t &vert2index,
+        arma::Mat <int> &contig_mat,
+        arma::Mat <float> &d_mat);
+
+template void utils_slk::mats_init <double, policy::Shortest> (
+        const utils::IndexView &from,
+        const utils::IndexView &to,
+        const double *d,
+        const int2indx_vec_t &vert2index,
+        arma::Mat <int> &contig_mat,
+        arma::Mat <double> &d_mat);
+
+template void utils_slk::mats_init <double, policy::Longest> (
+        const utils::IndexView &from,
+        const utils::IndexView &to,
+        const double *d,
+        const int2indx_vec_t &vert2index,
+        arma::Mat <int> &contig_mat,
+        arma::Mat <double> &d_mat);
+
+template void utils_slk::mats_init <policy::rank_t, policy::Shortest> (
+        const utils::IndexView &from,
+        const utils::IndexView &to,
+        const policy::rank_t *d,
+        const int2indx_vec_t &vert2index,
+        arma::Mat <int> &contig_mat,
+        arma::Mat <policy::rank_t> &d_mat);
+
+template void utils_slk::mats_init <policy::rank_t, policy::Longest> (
+        const utils::IndexView &from,
+        const utils::IndexView &to,
+        const policy::rank_t *d,
+        const int2indx_vec_t &vert2index,
+        arma::Mat <int> &contig_mat,
+        arma::Mat <policy::rank_t> &d_mat);
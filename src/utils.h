@@ -1,59 +1,155 @@
 #pragma once
 
+#include "policies.h"
+
 namespace utils {
 
 bool strfound (const std::string str, const std::string target);
 
+// Read-only view of a vector of vertex numbers, which wraps R (or C++) memory
+// without copying, and subtracts `offset` on access. R vectors are 1-indexed,
+// and so by default converted to 0-indexed values.
+class IndexView {
+    const int *ptr;
+    int n, offset;
+
+public:
+    explicit IndexView (const Rcpp::IntegerVector &x, const int offset_in = 1) :
+        ptr (x.begin ()), n (static_cast <int> (x.size ())),
+        offset (offset_in) {}
+    explicit IndexView (const std::vector <int> &x, const int offset_in = 0) :
+        ptr (x.data ()), n (static_cast <int> (x.size ())),
+        offset (offset_in) {}
+
+    int operator[] (const size_t i) const {
+        return ptr [i] - offset;
+    }
+    int operator() (const size_t i) const {
+        return ptr [i] - offset;
+    }
+    int size () const {
+        return n;
+    }
+    int length () const {
+        return n;
+    }
+};
+
+// Cluster memberships of matrix indices. The members of each cluster are held
+// in a contiguous vector, and merging always moves the smaller vector into the
+// larger, so each index is relabelled at most O(log n) times. Cluster numbers
+// are decoupled from the "slots" which hold the members, so that merging
+// cluster `from` into `to` retains the number `to` regardless of which vector
+// is moved. Clusters are initially numbered as their single member indices.
+class ClusterMembers {
+    std::vector <index_t> index2slot, cl2slot;
+    std::vector <int> slot2cl;
+    std::vector <std::vector <index_t> > slots;
+
+public:
+    void init (const size_t n) {
+        index2slot.resize (n);
+        cl2slot.resize (n);
+        slot2cl.resize (n);
+        slots.assign (n, std::vector <index_t> ());
+        for (size_t i = 0; i < n; i++) {
+            index2slot [i] = cl2slot [i] = i;
+            slot2cl [i] = static_cast <int> (i);
+            slots [i].push_back (i);
+        }
+    }
+
+    // Total number of cluster numbers, including those merged into others
+    size_t size () const {
+        return cl2slot.size ();
+    }
+    // `false` for clusters which have been merged into others
+    bool active (const int cl) const {
+        return cl >= 0 && static_cast <size_t> (cl) < cl2slot.size () &&
+            cl2slot [static_cast <size_t> (cl)] != NO_INDEX;
+    }
+    int cluster (const index_t i) const {
+        return slot2cl [index2slot [i]];
+    }
+    const std::vector <index_t> &members (const int cl) const {
+        return slots [cl2slot [static_cast <size_t> (cl)]];
+    }
+
+    void merge (const int cl_from, const int cl_to) {
+        const size_t cf = static_cast <size_t> (cl_from),
+                     ct = static_cast <size_t> (cl_to);
+        index_t big = cl2slot [ct], small = cl2slot [cf];
+        if (slots [big].size () < slots [small].size ()) {
+            std::swap (big, small);
+        }
+        for (auto i: slots [small]) {
+            index2slot [i] = big;
+        }
+        slots [big].insert (slots [big].end (),
+                slots [small].begin (), slots [small].end ());
+        std::vector <index_t> ().swap (slots [small]);
+
+        slot2cl [big] = cl_to;
+        cl2slot [ct] = big;
+        cl2slot [cf] = NO_INDEX;
+    }
+};
+
+// Edge distances are templated on the storage type, which is `float` for
+// `precision = "single"`, and otherwise `double`.
+template <typename T>
 struct OneEdge {
     int from, to;
-    double dist;
+    T dist;
 };
 
 size_t sets_init (
-        const Rcpp::IntegerVector &from,
-        const Rcpp::IntegerVector &to,
-        int2indx_map_t &vert2index_map,
-        indx2int_map_t &index2vert_map,
-        indx2int_map_t &index2cl_map,
-        int2indxset_map_t &cl2index_map);
+        const utils::IndexView &from,
+        const utils::IndexView &to,
+        int2indx_vec_t &vert2index,
+        indx2int_vec_t &index2vert,
+        utils::ClusterMembers &clusters);
+
+// Matrix index of vertex `v`, which must be present in the edge list passed to
+// `sets_init`.
+inline index_t vert_index (const int2indx_vec_t &vert2index, const int v) {
+    if (v < 0 || static_cast <size_t> (v) >= vert2index.size () ||
+            vert2index [static_cast <size_t> (v)] == NO_INDEX) {
+        throw std::runtime_error ("vertex not found in edge list");
+    }
+    return vert2index [static_cast <size_t> (v)];
+}
 
+// Templated on both distance type and comparison policy, Cmp, which is either
+// policy::Shortest or policy::Longest.
+template <typename T, typename Cmp>
 size_t find_shortest_connection (
-        const Rcpp::IntegerVector &from,
-        const Rcpp::IntegerVector &to,
-        const int2indx_map_t &vert2index_map,
-        const arma::Mat <double> &d_mat,
-        const int2indxset_map_t &cl2index_map,
+        const utils::IndexView &from,
+        const utils::IndexView &to,
+        const int2indx_vec_t &vert2index,
+        const arma::Mat <T> &d_mat,
+        const utils::ClusterMembers &clusters,
         const int cfrom,
-        const int cto,
-        const bool shortest);
+        const int cto);
 
 void merge_clusters (
         arma::Mat <int> &contig_mat,
-        indx2int_map_t &index2cl_map,
-        int2indxset_map_t &cl2index_map,
+        utils::ClusterMembers &clusters,
         const int merge_from,
         const int merge_to);
 
 } // end namespace utils
 
-// These are only used in slk
+// These are used in the shared agglomeration core
 namespace utils_slk {
 
+template <typename T, typename Cmp>
 void mats_init (
-        const Rcpp::IntegerVector &from,
-        const Rcpp::IntegerVector &to,
-        const Rcpp::NumericVector &d,
-        const int2indx_map_t &vert2index_map,
+        const utils::IndexView &from,
+        const utils::IndexView &to,
+        const typename policy::Input <T>::type *d,
+        const int2indx_vec_t &vert2index,
         arma::Mat <int> &contig_mat,
-        arma::Mat <double> &d_mat,
-        bool shortest);
-
-void dmat_full_init (
-        const Rcpp::IntegerVector &from,
-        const Rcpp::IntegerVector &to,
-        const Rcpp::NumericVector &d,
-        const int2indx_map_t &vert2index_map,
-        arma::Mat <double> &d_mat,
-        bool shortest);
+        arma::Mat <T> &d_mat);
 
 } // end namespace utils_slk